@@ -43,6 +43,7 @@ function Build-Vars {
     $global:objDir = Make-Path "$outputDir/obj"
     $global:srcDir = Make-Path "$inputDir/src"
     $global:incDir = Make-Path "$inputDir/include"
+    $global:nstdDir = Make-Path "./test"
     
     $global:inputAssetDir = Make-Path "$inputDir/assets"
     $global:inputShaderDir = Make-Path "$inputDir/shaders"
@@ -60,7 +61,7 @@ function Build-Clean {
 Build-Vars
 
 $CXX = "gcc"
-$CXXFLAGS = "-I$incDir -Ilib -Wall -c -g"
+$CXXFLAGS = "-std=c++20 -I$incDir -I$nstdDir -Ilib -Wall -c -g"
 $LDFLAGS = "-Llib -lglad -lglfw3 -lopengl32 -lgdi32 -lstdc++ -lstb"
 
 $objectBuild = "$CXX $LDFLAGS $CXXFLAGS"
@@ -83,6 +84,18 @@ function Check-Build-Cache {
         New-Item $cachePath
     }
 
+    ## check and update nstd cache
+    foreach ($file in Get-ChildItem -Path $nstdDir -File -Filter nstd.hpp) {
+        $cachePath = "$buildCache/$($file.BaseName).hc"
+        $filePath = "$nstdDir/$file"
+
+        $updated = ($cacheDated) -or (Check-Rebuild $filePath $cachePath)
+        $cacheDated = $cacheDated -or $updated
+
+        Rem-Path $cachePath
+        New-Item $cachePath
+    }
+
     ## check and update source cache
     foreach ($file in Get-ChildItem -Path $srcDir -File -Filter *.cpp) {
         $cachePath = "$buildCache/$($file.BaseName).sc"
@@ -116,6 +129,13 @@ function Build-Compile {
                 Write-Output "$CXX $srcDir/$file $LDFLAGS $CXXFLAGS -o $outputFile"
             }
         }
+
+        ## build nstd
+        $nstdObject = Join-Path $objDir "nstd.o"
+        if ($cacheDated -or (Check-Rebuild "$nstdDir/nstd.cpp" $nstdObject)) {
+            Invoke-Expression "$CXX $nstdDir/nstd.cpp $LDFLAGS $CXXFLAGS -o $nstdObject"
+            Write-Output "$CXX $nstdDir/nstd.cpp $LDFLAGS $CXXFLAGS -o $nstdObject"
+        }
     }
 
     ## link executable
@@ -129,6 +149,10 @@ function Run {
     Push-Location -Path $outputDir; Invoke-Expression ".\$executable"; Pop-Location
 }
 
+function Pack-Shaders {
+    Push-Location -Path $outputDir; Invoke-Expression ".\$executable --pack-shaders"; Pop-Location
+}
+
 function Build-Project {
     Build-Clean
     Build-Compile
@@ -137,8 +161,19 @@ function Build-Project {
     Run
 }
 
+function Build-Release {
+    Build-Clean
+    Build-Compile
+    Smart-Copy $inputAssetDir $outputAssetDir
+    Smart-Copy $inputShaderDir $outputShaderDir
+    Pack-Shaders
+}
+
 function Reload-Assets {
     Smart-Copy $inputAssetDir $outputAssetDir
     Smart-Copy $inputShaderDir $outputShaderDir
+
+    ## a pack would serve the old shaders over the copied ones
+    Clean-File "$outputShaderDir/shaders.pak"
     Run
 }
\ No newline at end of file
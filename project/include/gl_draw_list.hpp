@@ -0,0 +1,89 @@
+#ifndef _GL_DRAW_LIST_HPP
+#define _GL_DRAW_LIST_HPP
+
+// draws of one shader and state bucket collected over a frame and issued
+// with a single glMultiDrawElementsIndirect over a geometry arena, optionally
+// frustum culled on the gpu by a compute pass that rewrites the commands
+struct DrawList {
+    // binding of the per object storage buffer, matches triangle_mdi.vert and cull.comp
+    static constexpr GLuint object_binding = 0;
+
+    // binding of the command buffer in the cull pass, matches cull.comp
+    static constexpr GLuint command_binding = 1;
+
+    // commands culled per compute work group, matches cull.comp
+    static constexpr GLuint cull_group_size = 64;
+
+    // layout of DrawElementsIndirectCommand
+    typedef struct {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    } DrawCommand;
+
+    // per object data, std430 layout, indexed by gl_BaseInstance + gl_InstanceID
+    typedef struct {
+        glm::mat4 model;
+        glm::vec4 bounds;       // mesh space bounding sphere, a negative radius is never culled
+        nstd::U32 material;
+        nstd::U32 pad[3];
+    } ObjectData;
+
+    const GeometryArena* arena;
+    std::vector<DrawCommand> commands;
+    std::vector<ObjectData> objects;
+
+    // rewritten every submit, regions stay untouched while earlier frames draw from them
+    StreamBuffer command_buffer;
+    StreamBuffer object_buffer;
+    GLint storage_alignment;
+
+    // create a draw list
+    DrawList();
+
+    // destroy a draw list and its buffers
+    ~DrawList();
+
+    // secondary intialization, draws come from meshes in arena
+    void init(const GeometryArena* arena);
+
+    // whether the driver has gl 4.3 for multi draw indirect and storage buffers, and the
+    // draw parameters extension
+    static bool supported();
+
+    // whether the driver has compute shaders for culling on the gpu
+    static bool culling_supported();
+
+    // drop the draws of the last frame
+    void clear();
+
+    // add a draw of an arena allocation, optionally of a sub range of its indices
+    void add(
+        nstd::U32 handle, 
+        const SceneObject* binding, 
+        nstd::U32 material = 0, 
+        nstd::U32 first_index = 0, 
+        nstd::U32 index_count = 0xFFFFFFFF
+    );
+
+    // add a draw of one level of a mesh, the mesh has to live in the list's arena
+    void add(const Mesh* mesh, const SceneObject* binding, nstd::U32 material = 0, int lod = 0);
+
+    // add draws of index ranges of a mesh sharing one object entry, as left by meshlet culling
+    void add(const Mesh* mesh, const SceneObject* binding, const MeshletSet::Range* ranges, size_t count, nstd::U32 material = 0);
+
+    // upload the frame's draws and issue them in one call, once per frame. with a cull shader the
+    // commands of objects outside the camera's frustum are zeroed on the gpu before the draw
+    void submit(const ShaderProgram* shader, const ShaderProgram* cull_shader = nullptr, const Camera* camera = nullptr);
+
+private:
+    // bounding sphere of a mesh's bounds
+    static glm::vec4 bounds_of(const Mesh* mesh);
+
+    // write data into the next region of a stream buffer, growing it if needed, returns its offset
+    static size_t upload(StreamBuffer* buffer, const void* data, size_t size, size_t alignment);
+};
+
+#endif
@@ -13,6 +13,9 @@ struct ElementBuffer {
     // init the element buffer object within openGL
     void init(const std::vector<GLuint>& data);
 
+    // init from raw index data of any index type
+    void init(const void* data, size_t size);
+
     // bind as current element buffer
     void bind();
 
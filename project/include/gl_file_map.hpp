@@ -0,0 +1,42 @@
+#ifndef _GL_FILE_MAP_HPP
+#define _GL_FILE_MAP_HPP
+
+// read only view of a whole file mapped into memory
+struct MappedFile {
+    const char* data;
+    size_t size;
+
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+
+    // create an unmapped file
+    MappedFile();
+
+    // unmaps the file
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // map a file, returns false if it can not be opened
+    bool open(const char* path);
+
+    // unmap the file
+    void close();
+};
+
+// size and last write time of a file, for telling whether it changed since it was last seen
+struct FileStamp {
+    nstd::U64 size;
+    nstd::U64 mtime;    // nanoseconds, at the resolution the file system keeps
+
+    // stat a file, returns false if it does not exist
+    static bool get(const char* path, FileStamp* out);
+
+    bool operator==(const FileStamp& other) const;
+    bool operator!=(const FileStamp& other) const;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef _GL_GEOMETRY_ARENA_HPP
+#define _GL_GEOMETRY_ARENA_HPP
+
+// sub-allocates vertex and index ranges of many meshes sharing one vertex format
+// from a single vertex buffer and index buffer under one vertex array
+struct GeometryArena {
+    static constexpr nstd::U32 default_vertex_capacity = 1 << 16;
+    static constexpr nstd::U32 default_index_capacity = 1 << 18;
+    static constexpr nstd::U32 invalid_handle = 0xFFFFFFFF;
+
+    // first fit allocator over element ranges, neighbouring free ranges merge on free
+    struct RangeList {
+        std::map<nstd::U32, nstd::U32> free_ranges;     // offset -> count
+        nstd::U32 capacity;
+        nstd::U32 used;
+
+        // reset to a single free range
+        void init(nstd::U32 capacity);
+
+        // returns false if no free range is large enough
+        bool alloc(nstd::U32 count, nstd::U32* offset);
+
+        // return a range
+        void free(nstd::U32 offset, nstd::U32 count);
+
+        // extend the capacity, the new tail is free
+        void grow(nstd::U32 capacity);
+
+        // reset to [0, used) allocated after compaction
+        void pack(nstd::U32 used);
+    };
+
+    // ranges of a mesh within the arena buffers
+    typedef struct {
+        nstd::U32 base_vertex;
+        nstd::U32 vertex_count;
+        nstd::U32 first_index;
+        nstd::U32 index_count;
+        bool live;
+    } Allocation;
+
+    VertexArray VAO;
+    GLuint vertex_buffer;
+    GLuint index_buffer;
+    GLsizei vertex_size;
+    std::vector<VertexArray::Attribute> attributes;
+
+    RangeList vertex_ranges;
+    RangeList index_ranges;
+
+    std::vector<Allocation> allocations;
+    std::vector<nstd::U32> free_handles;
+
+    // create an arena
+    GeometryArena();
+
+    // destroy an arena and its buffers
+    ~GeometryArena();
+
+    // secondary intialization, vertex_size is the stride of the vertex format
+    void init(
+        GLsizei vertex_size, 
+        const VertexArray::Attribute* attributes, 
+        int num_attributes,
+        nstd::U32 vertex_capacity = default_vertex_capacity,
+        nstd::U32 index_capacity = default_index_capacity
+    );
+
+    // secondary intialization for a vertex format with a VertexLayout
+    template <typename V>
+    void init(
+        nstd::U32 vertex_capacity = default_vertex_capacity, 
+        nstd::U32 index_capacity = default_index_capacity
+    );
+
+    // upload a mesh into the arena, indices are relative to the mesh's first vertex
+    nstd::U32 alloc(const void* vertices, nstd::U32 vertex_count, const GLuint* indices, nstd::U32 index_count);
+
+    // release a mesh's ranges for reuse
+    void free(nstd::U32 handle);
+
+    // moves all live ranges to the front of the buffers, handles stay valid
+    void compact();
+
+    // ranges of a mesh
+    const Allocation* get(nstd::U32 handle) const;
+
+    // bind the shared vertex array
+    void bind() const;
+
+    // draw a mesh with glDrawElementsBaseVertex
+    void draw(nstd::U32 handle, GLenum mode = GL_TRIANGLES) const;
+
+    // draw a sub range of a mesh's indices, first_index is relative to the mesh
+    void draw(nstd::U32 handle, nstd::U32 first_index, nstd::U32 index_count, GLenum mode = GL_TRIANGLES) const;
+
+private:
+    // point the vertex array at the current buffers
+    void attach_buffers();
+
+    // replace a buffer with a larger one keeping its contents
+    void grow_buffer(GLuint* buffer, size_t old_size, size_t new_size);
+};
+
+template <typename V>
+void GeometryArena::init(nstd::U32 vertex_capacity, nstd::U32 index_capacity) {
+    init(sizeof(V), VertexLayout<V>::attributes, VertexLayout<V>::count, vertex_capacity, index_capacity);
+}
+
+#endif
@@ -1,24 +1,230 @@
 #ifndef _GL_MESH_HPP
 #define _GL_MESH_HPP
 
+// gl index type of an index array element
+template <typename I> struct IndexFormat;
+
+template <> struct IndexFormat<GLuint> { static constexpr GLenum type = GL_UNSIGNED_INT; };
+template <> struct IndexFormat<nstd::U16> { static constexpr GLenum type = GL_UNSIGNED_SHORT; };
+
 struct Mesh {
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
+    typedef enum {
+        MESH_RELEASE_CPU_DATA,
+        MESH_KEEP_CPU_DATA,
+    } CpuData;
+
+    // a level is used while its error covers at most this many pixels on screen
+    static constexpr float default_lod_pixel_error = 1.0f;
+
+    // cpu copies, only held with MESH_KEEP_CPU_DATA
+    std::shared_ptr<const void> vertex_owner;
+    std::shared_ptr<const void> index_owner;
+    const void* vertices;
+    const void* indices;
 
     VertexArray VAO;
     VertexBuffer VBO;
     ElementBuffer EBO;
 
-    // creates a mesh
+    GLsizei vertex_size;
+    GLenum index_type;
+    size_t vertex_count;
+    size_t index_count;
+
+    // object space bounds, kept when the cpu data is released
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+
+    // post-transform cache efficiency of the uploaded index order
+    MeshOptimizer::Stats cache_stats;
+
+    // levels of detail within the index buffer, level 0 is the full mesh
+    std::vector<MeshSimplifier::Level> lods;
+
+    // clusters of level 0 for per cluster culling, empty unless loaded from a mesh file that has them
+    MeshletSet meshlets;
+
+    // set when the mesh lives in a shared arena instead of its own buffers
+    GeometryArena* arena;
+    nstd::U32 arena_handle;
+
+    // creates a mesh of any vertex format with a VertexLayout and 16 or 32 bit indices, uploading straight
+    // from the caller's buffers and into arena when given one, the arena only takes 32 bit indices
+    template <typename V, typename I>
     Mesh(
-        const std::vector<Vertex>& vertices, 
-        const std::vector<GLuint>& indices
+        nstd::Span<const V> vertices, 
+        nstd::Span<const I> indices,
+        GeometryArena* arena = nullptr,
+        CpuData cpu_data = MESH_RELEASE_CPU_DATA
     );
 
+    // creates a mesh from vectors, copied only with MESH_KEEP_CPU_DATA
+    template <typename V, typename I>
+    Mesh(
+        const std::vector<V>& vertices, 
+        const std::vector<I>& indices,
+        GeometryArena* arena = nullptr,
+        CpuData cpu_data = MESH_RELEASE_CPU_DATA
+    );
+
+    // creates a mesh taking over the vectors, they are kept without a copy with MESH_KEEP_CPU_DATA
+    template <typename V, typename I>
+    Mesh(
+        std::vector<V>&& vertices, 
+        std::vector<I>&& indices,
+        GeometryArena* arena = nullptr,
+        CpuData cpu_data = MESH_RELEASE_CPU_DATA
+    );
+
+    // creates a mesh drawn at any level of a lod chain
+    template <typename V>
+    Mesh(
+        const std::vector<V>& vertices, 
+        const MeshSimplifier::Chain& chain,
+        GeometryArena* arena = nullptr,
+        CpuData cpu_data = MESH_RELEASE_CPU_DATA
+    );
+
+    // creates a mesh of a submesh of a mapped mesh file, uploading straight from the mapping
+    Mesh(const MeshFile* file, nstd::U32 submesh, GeometryArena* arena = nullptr);
+
     ~Mesh();
 
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    // drop the cpu copies, counts and bounds stay
+    void release_cpu_data();
+
+    // log the cache statistics of the mesh
+    void log_stats(const char* name) const;
+
+    // coarsest level whose error stays under pixel_error when the mesh is seen through camera
+    int select_lod(const Camera* camera, const SceneObject* binding, float pixel_error = default_lod_pixel_error) const;
+
     // draws mesh with shader
-    void draw(const ShaderProgram* shader, const SceneObject* binding);
+    void draw(const ShaderProgram* shader, const SceneObject* binding, int lod = 0);
+
+private:
+    // bounds of the vertex positions
+    template <typename V>
+    void compute_bounds(nstd::Span<const V> vertices);
+
+    // upload into the mesh's own buffers or the arena
+    void upload(
+        const void* vertex_data, 
+        size_t vertex_count, 
+        GLsizei vertex_size, 
+        const VertexArray::Attribute* attributes, 
+        int num_attributes,
+        const void* index_data,
+        size_t index_count,
+        GLenum index_type,
+        GeometryArena* arena
+    );
 };
 
-#endif
\ No newline at end of file
+template <typename V, typename I>
+Mesh::Mesh(
+    nstd::Span<const V> vertices, 
+    nstd::Span<const I> indices,
+    GeometryArena* arena,
+    CpuData cpu_data
+) {
+    this->vertices = nullptr;
+    this->indices = nullptr;
+    this->cache_stats = MeshOptimizer::analyze(indices.data, indices.len, vertices.len);
+    this->lods.push_back({ 0, (nstd::U32) indices.len, 0.0f });
+
+    compute_bounds(vertices);
+    upload(
+        vertices.data, vertices.len, sizeof(V), 
+        VertexLayout<V>::attributes, VertexLayout<V>::count, 
+        indices.data, indices.len, IndexFormat<I>::type,
+        arena
+    );
+
+    if (cpu_data == MESH_KEEP_CPU_DATA) {
+        std::shared_ptr<const std::vector<V>> owned_vertices = std::make_shared<const std::vector<V>>(vertices.begin(), vertices.end());
+        std::shared_ptr<const std::vector<I>> owned_indices = std::make_shared<const std::vector<I>>(indices.begin(), indices.end());
+
+        this->vertices = owned_vertices->data();
+        this->indices = owned_indices->data();
+        this->vertex_owner = std::move(owned_vertices);
+        this->index_owner = std::move(owned_indices);
+    }
+}
+
+template <typename V, typename I>
+Mesh::Mesh(
+    const std::vector<V>& vertices, 
+    const std::vector<I>& indices,
+    GeometryArena* arena,
+    CpuData cpu_data
+) : Mesh(
+    nstd::Span<const V> { vertices.data(), vertices.size() }, 
+    nstd::Span<const I> { indices.data(), indices.size() }, 
+    arena, 
+    cpu_data
+) {}
+
+template <typename V, typename I>
+Mesh::Mesh(
+    std::vector<V>&& vertices, 
+    std::vector<I>&& indices,
+    GeometryArena* arena,
+    CpuData cpu_data
+) : Mesh(
+    nstd::Span<const V> { vertices.data(), vertices.size() }, 
+    nstd::Span<const I> { indices.data(), indices.size() }, 
+    arena, 
+    MESH_RELEASE_CPU_DATA
+) {
+    if (cpu_data == MESH_KEEP_CPU_DATA) {
+        std::shared_ptr<const std::vector<V>> owned_vertices = std::make_shared<const std::vector<V>>(std::move(vertices));
+        std::shared_ptr<const std::vector<I>> owned_indices = std::make_shared<const std::vector<I>>(std::move(indices));
+
+        this->vertices = owned_vertices->data();
+        this->indices = owned_indices->data();
+        this->vertex_owner = std::move(owned_vertices);
+        this->index_owner = std::move(owned_indices);
+    } else {
+        // the caller gave the buffers away, free them now rather than when it goes out of scope
+        std::vector<V>().swap(vertices);
+        std::vector<I>().swap(indices);
+    }
+}
+
+template <typename V>
+Mesh::Mesh(
+    const std::vector<V>& vertices, 
+    const MeshSimplifier::Chain& chain,
+    GeometryArena* arena,
+    CpuData cpu_data
+) : Mesh(vertices, chain.indices, arena, cpu_data) {
+    this->lods = chain.levels;
+
+    if (!this->lods.empty()) {
+        this->cache_stats = MeshOptimizer::analyze(chain.indices.data(), this->lods[0].index_count, vertices.size());
+    }
+}
+
+template <typename V>
+void Mesh::compute_bounds(nstd::Span<const V> vertices) {
+    this->bounds_min = glm::vec3(0);
+    this->bounds_max = glm::vec3(0);
+
+    if (vertices.len == 0) {
+        return;
+    }
+
+    this->bounds_min = vertices[0].position;
+    this->bounds_max = vertices[0].position;
+
+    for (const V& vertex : vertices) {
+        this->bounds_min = glm::min(this->bounds_min, vertex.position);
+        this->bounds_max = glm::max(this->bounds_max, vertex.position);
+    }
+}
+
+#endif
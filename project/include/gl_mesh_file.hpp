@@ -0,0 +1,131 @@
+#ifndef _GL_MESH_FILE_HPP
+#define _GL_MESH_FILE_HPP
+
+// versioned binary mesh container in gpu ready layout. sections are 64 byte aligned so the
+// mapped file is used in place, buffers are uploaded straight from the mapping
+//
+// layout: header, submesh table, lod table, meshlet table, vertex blob, index blob
+struct MeshFile {
+    static constexpr nstd::U32 magic = 0x4853454D;      // "MESH"
+    static constexpr nstd::U32 version = 3;
+    static constexpr size_t alignment = 64;
+
+    typedef enum {
+        MESH_FORMAT_VERTEX,
+        MESH_FORMAT_COMPACT,
+        MESH_FORMAT_POSITION,
+        MESH_FORMAT_MAX,
+    } VertexFormat;
+
+    typedef struct {
+        nstd::U32 magic;
+        nstd::U32 version;
+        nstd::U32 vertex_format;
+        nstd::U32 vertex_size;
+
+        nstd::U32 vertex_count;
+        nstd::U32 index_count;        // 32 bit indices, relative to their submesh's base vertex
+        nstd::U32 submesh_count;
+        nstd::U32 lod_count;
+
+        nstd::U64 submesh_offset;
+        nstd::U64 lod_offset;
+        nstd::U64 vertex_offset;
+        nstd::U64 index_offset;
+
+        float bounds_min[3];
+        float bounds_max[3];
+        nstd::U64 file_size;
+
+        nstd::U64 meshlet_offset;
+        nstd::U32 meshlet_count;
+        nstd::U32 pad;
+
+        // stamp of the file the mesh was baked from, zero when baked without one
+        nstd::U64 source_size;
+        nstd::U64 source_mtime;
+    } Header;
+
+    // a mesh within the file, its lods are contiguous in the lod table and in the index blob,
+    // its meshlets split lod 0
+    typedef struct {
+        char name[40];
+
+        nstd::U32 base_vertex;
+        nstd::U32 vertex_count;
+        nstd::U32 first_lod;
+        nstd::U32 lod_count;
+        nstd::U32 first_meshlet;
+        nstd::U32 meshlet_count;
+
+        float bounds_min[3];
+        float bounds_max[3];
+
+        MeshOptimizer::Stats cache_stats;
+    } Submesh;
+
+    MappedFile file;
+    const Header* header;
+    const Submesh* submeshes;
+    const MeshSimplifier::Level* lods;      // first_index into the whole index blob
+    const MeshletSet::Meshlet* meshlets;    // first_index into the whole index blob
+    const nstd::U8* vertices;
+    const GLuint* indices;
+
+    // create a closed mesh file
+    MeshFile();
+
+    MeshFile(const MeshFile&) = delete;
+    MeshFile& operator=(const MeshFile&) = delete;
+
+    // map and validate a mesh file, the tables and the indices are checked, vertices are not read
+    bool open(const char* path);
+
+    // whether the open file was baked from source_path as it is now, a missing source matches
+    // so meshes shipped without their source still load
+    bool matches_source(const char* source_path) const;
+
+    // unmap the file, meshes created from it keep their buffers
+    void close();
+
+    // submesh by index, nullptr if out of range
+    const Submesh* get_submesh(nstd::U32 index) const;
+
+    // submesh by name, nullptr if not found
+    const Submesh* find_submesh(const char* name) const;
+
+    // vertex array layout of a format
+    static const VertexArray::Attribute* get_layout(VertexFormat format, int* count);
+
+    // write a mesh file, lods, meshlets and submeshes reference the given blobs as they will be laid out
+    static bool write(
+        const char* path,
+        VertexFormat format,
+        nstd::U32 vertex_size,
+        const void* vertices,
+        nstd::U32 vertex_count,
+        const GLuint* indices,
+        nstd::U32 index_count,
+        const Submesh* submeshes,
+        nstd::U32 submesh_count,
+        const MeshSimplifier::Level* lods,
+        nstd::U32 lod_count,
+        const MeshletSet::Meshlet* meshlets = nullptr,
+        nstd::U32 meshlet_count = 0,
+        const char* source_path = nullptr
+    );
+
+    // format id of a vertex type
+    template <typename V>
+    static constexpr VertexFormat format_of();
+};
+
+static_assert(sizeof(MeshFile::Header) == 128, "MeshFile::Header layout changed");
+static_assert(sizeof(MeshFile::Submesh) == 96, "MeshFile::Submesh layout changed");
+static_assert(sizeof(MeshSimplifier::Level) == 12, "MeshSimplifier::Level layout changed");
+
+template <> constexpr MeshFile::VertexFormat MeshFile::format_of<Vertex>() { return MESH_FORMAT_VERTEX; }
+template <> constexpr MeshFile::VertexFormat MeshFile::format_of<VertexCompact>() { return MESH_FORMAT_COMPACT; }
+template <> constexpr MeshFile::VertexFormat MeshFile::format_of<VertexPosition>() { return MESH_FORMAT_POSITION; }
+
+#endif
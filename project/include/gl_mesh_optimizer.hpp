@@ -0,0 +1,130 @@
+#ifndef _GL_MESH_OPTIMIZER_HPP
+#define _GL_MESH_OPTIMIZER_HPP
+
+// offline index and vertex reordering for post-transform cache, overdraw and fetch locality
+struct MeshOptimizer {
+    // cache size the triangle order is tuned for, matches typical post-transform caches
+    static constexpr int cache_size = 32;
+
+    // fifo size used for reported statistics
+    static constexpr int analyze_cache_size = 16;
+
+    // clusters may lose this much cache efficiency to get a better overdraw order
+    static constexpr float default_overdraw_threshold = 1.05f;
+
+    // post-transform cache efficiency of an index order
+    typedef struct {
+        float acmr;     // average cache miss ratio, transformed vertices per triangle, 0.5 is ideal
+        float atvr;     // average transform to vertex ratio, 1.0 is ideal
+    } Stats;
+
+    // statistics before and after optimize
+    typedef struct {
+        Stats before;
+        Stats after;
+        bool narrow;    // whether the indices fit in 16 bits
+    } Report;
+
+    // simulates a fifo cache over the triangle list
+    template <typename I>
+    static Stats analyze(const I* indices, size_t index_count, size_t vertex_count, int fifo_size = analyze_cache_size);
+
+    // reorders triangles for vertex cache locality (Forsyth's linear speed algorithm)
+    static void optimize_vertex_cache(GLuint* indices, size_t index_count, size_t vertex_count);
+
+    // reorders cache optimized triangle clusters front to back from the outside of the mesh
+    static void optimize_overdraw(
+        GLuint* indices, 
+        size_t index_count, 
+        const float* positions, 
+        size_t position_stride, 
+        size_t vertex_count, 
+        float threshold = default_overdraw_threshold
+    );
+
+    // builds a remap table ordering vertices by first use, unused vertices map to ~0u, returns the used count
+    static size_t optimize_vertex_fetch_remap(GLuint* remap, const GLuint* indices, size_t index_count, size_t vertex_count);
+
+    // copies indices to 16 bit if every index fits
+    static bool narrow_indices(const GLuint* indices, size_t index_count, std::vector<nstd::U16>* out);
+
+    // runs all passes on a mesh in place
+    template <typename V>
+    static Report optimize(std::vector<V>* vertices, std::vector<GLuint>* indices, float overdraw_threshold = default_overdraw_threshold);
+
+    // logs a report
+    static void log_report(const char* name, const Report* report);
+};
+
+template <typename I>
+MeshOptimizer::Stats MeshOptimizer::analyze(const I* indices, size_t index_count, size_t vertex_count, int fifo_size) {
+    Stats stats = { 0.0f, 0.0f };
+    if (index_count < 3) {
+        return stats;
+    }
+
+    // a vertex is in the fifo while fewer than fifo_size misses happened since it was loaded
+    std::vector<size_t> loaded_at(vertex_count, 0);
+    std::vector<bool> used(vertex_count, false);
+    size_t misses = 0;
+    size_t unique = 0;
+
+    for (size_t i = 0; i < index_count; i++) {
+        size_t v = indices[i];
+
+        if (!used[v]) {
+            used[v] = true;
+            unique++;
+        }
+
+        if (loaded_at[v] == 0 || misses - loaded_at[v] >= (size_t) fifo_size) {
+            misses++;
+            loaded_at[v] = misses;
+        }
+    }
+
+    stats.acmr = (float) misses / (float) (index_count / 3);
+    stats.atvr = unique ? (float) misses / (float) unique : 0.0f;
+    return stats;
+}
+
+template <typename V>
+MeshOptimizer::Report MeshOptimizer::optimize(std::vector<V>* vertices, std::vector<GLuint>* indices, float overdraw_threshold) {
+    Report report;
+    report.before = analyze(indices->data(), indices->size(), vertices->size());
+
+    if (vertices->empty() || indices->size() < 3) {
+        report.after = report.before;
+        report.narrow = vertices->size() <= 0xFFFF;
+        return report;
+    }
+
+    optimize_vertex_cache(indices->data(), indices->size(), vertices->size());
+    optimize_overdraw(
+        indices->data(), indices->size(), 
+        (const float*) &(*vertices)[0].position, sizeof(V), vertices->size(), 
+        overdraw_threshold
+    );
+
+    std::vector<GLuint> remap(vertices->size());
+    size_t used = optimize_vertex_fetch_remap(remap.data(), indices->data(), indices->size(), vertices->size());
+
+    std::vector<V> reordered(used);
+    for (size_t v = 0; v < vertices->size(); v++) {
+        if (remap[v] != ~0u) {
+            reordered[remap[v]] = (*vertices)[v];
+        }
+    }
+
+    for (GLuint& index : *indices) {
+        index = remap[index];
+    }
+
+    *vertices = std::move(reordered);
+
+    report.after = analyze(indices->data(), indices->size(), vertices->size());
+    report.narrow = vertices->size() <= 0xFFFF;
+    return report;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef _GL_MESH_SIMPLIFIER_HPP
+#define _GL_MESH_SIMPLIFIER_HPP
+
+// offline level of detail generation by quadric error edge collapse, levels reuse the
+// vertices of the full mesh and only differ in their indices
+struct MeshSimplifier {
+    // one level of detail within a chain's index array
+    typedef struct {
+        nstd::U32 first_index;
+        nstd::U32 index_count;
+        float error;            // geometric error relative to the mesh extent
+    } Level;
+
+    // controls of lod chain generation
+    typedef struct {
+        float ratio;            // index count of each level relative to the one before
+        float max_error;        // error relative to the mesh extent no level may exceed
+        int max_levels;         // including the full detail level
+    } Settings;
+
+    // all levels of a mesh, level 0 is the full mesh
+    typedef struct {
+        std::vector<GLuint> indices;
+        std::vector<Level> levels;
+    } Chain;
+
+    // a level is dropped when it removes less than this fraction of the level before
+    static constexpr float min_reduction = 0.1f;
+
+    static constexpr Settings default_settings = { 0.5f, 0.05f, 6 };
+
+    // collapses edges until target_index_count is reached or the next collapse would exceed
+    // target_error, returns the new index count. vertices on open edges stay in place, copies of
+    // a vertex on an attribute seam only slide along the seam together so it stays closed
+    static size_t simplify(
+        GLuint* out,
+        const GLuint* indices,
+        size_t index_count,
+        const float* positions,
+        size_t position_stride,
+        size_t vertex_count,
+        size_t target_index_count,
+        float target_error,
+        float* result_error = nullptr
+    );
+
+    // builds a chain of levels, each simplified from the one before and vertex cache optimized
+    static Chain build_lods(
+        const GLuint* indices,
+        size_t index_count,
+        const float* positions,
+        size_t position_stride,
+        size_t vertex_count,
+        const Settings* settings = &default_settings
+    );
+
+    // builds a chain for a mesh of any vertex format with a position member
+    template <typename V>
+    static Chain build_lods(
+        const std::vector<V>& vertices,
+        const std::vector<GLuint>& indices,
+        const Settings* settings = &default_settings
+    );
+};
+
+template <typename V>
+MeshSimplifier::Chain MeshSimplifier::build_lods(
+    const std::vector<V>& vertices,
+    const std::vector<GLuint>& indices,
+    const Settings* settings
+) {
+    const float* positions = vertices.empty() ? nullptr : (const float*) &vertices[0].position;
+    return build_lods(indices.data(), indices.size(), positions, sizeof(V), vertices.size(), settings);
+}
+
+#endif
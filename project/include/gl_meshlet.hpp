@@ -0,0 +1,87 @@
+#ifndef _GL_MESHLET_HPP
+#define _GL_MESHLET_HPP
+
+// a mesh's triangles split into small clusters with bounding spheres and normal cones, culled
+// on the cpu so only clusters facing the camera and inside the frustum are drawn
+struct MeshletSet {
+    static constexpr nstd::U32 max_vertices = 64;
+    static constexpr nstd::U32 max_triangles = 124;
+
+    // clusters below this many per worker are culled on the calling thread
+    static constexpr size_t min_parallel_meshlets = 4096;
+
+    // a cluster and its culling bounds in mesh space, 64 bytes as stored in mesh files
+    typedef struct {
+        nstd::U32 first_index;
+        nstd::U32 triangle_count;
+        nstd::U32 vertex_count;
+        nstd::U32 pad;
+
+        float center[3];
+        float radius;
+
+        // backfacing from every point p where dot(normalize(cone_apex - p), cone_axis) >= cone_cutoff,
+        // a cutoff of 1 never culls
+        float cone_apex[3];
+        float cone_cutoff;
+        float cone_axis[3];
+        float pad1;
+    } Meshlet;
+
+    // a contiguous run of visible triangles
+    typedef struct {
+        nstd::U32 first_index;
+        nstd::U32 index_count;
+    } Range;
+
+    // culling inputs, one array per field padded to a multiple of 4 clusters
+    typedef enum {
+        CULL_CENTER_X,
+        CULL_CENTER_Y,
+        CULL_CENTER_Z,
+        CULL_RADIUS,
+        CULL_APEX_X,
+        CULL_APEX_Y,
+        CULL_APEX_Z,
+        CULL_AXIS_X,
+        CULL_AXIS_Y,
+        CULL_AXIS_Z,
+        CULL_CUTOFF,
+        CULL_FIELD_MAX,
+    } CullField;
+
+    std::vector<Meshlet> meshlets;
+    std::vector<float> cull_data;
+    size_t padded_count;
+
+    // create an empty set
+    MeshletSet();
+
+    // take clusters, first_index is rebased by index_base
+    void init(const Meshlet* meshlets, size_t count, nstd::U32 index_base = 0);
+
+    // reorders a triangle list into clusters written to out_indices, clusters grow over shared
+    // vertices so they stay compact, returns the clusters
+    static std::vector<Meshlet> build(
+        GLuint* out_indices,
+        const GLuint* indices,
+        size_t index_count,
+        const float* positions,
+        size_t position_stride,
+        size_t vertex_count
+    );
+
+    // visible clusters given the mesh space frustum of model_view_projection and the mesh space
+    // camera position, cone tests are only valid without non uniform scale
+    void cull(const glm::mat4& model_view_projection, glm::vec3 camera_position, bool cone_culling, std::vector<nstd::U32>* visible) const;
+
+    // visible clusters of a mesh placed by binding and seen through camera
+    void cull(const Camera* camera, const SceneObject* binding, std::vector<nstd::U32>* visible) const;
+
+    // merge visible clusters that are neighbours in the index buffer into draw ranges
+    void get_ranges(const std::vector<nstd::U32>& visible, std::vector<Range>* ranges) const;
+};
+
+static_assert(sizeof(MeshletSet::Meshlet) == 64, "MeshletSet::Meshlet layout changed");
+
+#endif
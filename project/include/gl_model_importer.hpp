@@ -0,0 +1,166 @@
+#ifndef _GL_MODEL_IMPORTER_HPP
+#define _GL_MODEL_IMPORTER_HPP
+
+// loads OBJ and glTF (.gltf, .glb) models into Vertex meshes, parsing on worker threads,
+// and keeps a binary cache next to the source so later loads skip parsing entirely
+struct ModelImporter {
+    static constexpr nstd::U32 cache_magic = 0x4843434D;     // "MCCH"
+    static constexpr nstd::U32 cache_version = 2;
+    static constexpr const char* cache_extension = ".mcache";
+
+    // obj files are split into chunks of at least this size, one per worker
+    static constexpr size_t min_chunk_size = 1 << 20;
+
+    // one mesh of a model, an obj object or group or a gltf primitive
+    typedef struct {
+        std::string name;
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
+    } Part;
+
+    typedef struct {
+        std::vector<Part> parts;
+    } Model;
+
+    // cache file layout, all parts follow the header
+    typedef struct {
+        nstd::U32 magic;
+        nstd::U32 version;
+        nstd::U64 source_size;
+        nstd::U64 source_mtime;     // nanoseconds
+        nstd::U32 part_count;
+        nstd::U32 vertex_size;
+    } CacheHeader;
+
+    // part layout in the cache, followed by the name padded to 8 bytes, the vertices and the indices
+    typedef struct {
+        nstd::U32 name_length;
+        nstd::U32 vertex_count;
+        nstd::U32 index_count;
+        nstd::U32 pad;
+    } CachePart;
+
+    // load a model by extension, from its cache when the cache matches the source
+    static bool load(const char* path, Model* model, bool use_cache = true);
+
+    // parse an obj file, vertices with the same position, uv and normal are welded
+    static bool load_obj(const char* path, Model* model, int threads = 0);
+
+    // parse a gltf or glb file, one part per triangle primitive in mesh space
+    static bool load_gltf(const char* path, Model* model, int threads = 0);
+
+    // read a cache, fails if it was written for another version of the source
+    static bool read_cache(const char* cache_path, const char* source_path, Model* model);
+
+    // write a cache for a source
+    static bool write_cache(const char* cache_path, const char* source_path, const Model* model);
+
+    // create meshes of a model's parts, converting to vertex format V
+    template <typename V>
+    static std::vector<std::unique_ptr<Mesh>> create_meshes(const Model* model, GeometryArena* arena = nullptr);
+
+    // bake a model into a mesh file of vertex format V, one submesh per part, each optimized
+    // for the vertex cache, given a lod chain and split into meshlets at lod 0. the file is
+    // stamped with source_path so a changed source can be detected
+    template <typename V>
+    static bool write_mesh_file(
+        const char* path, 
+        const Model* model, 
+        const MeshSimplifier::Settings* lod_settings = &MeshSimplifier::default_settings,
+        const char* source_path = nullptr
+    );
+};
+
+template <typename V>
+std::vector<std::unique_ptr<Mesh>> ModelImporter::create_meshes(const Model* model, GeometryArena* arena) {
+    std::vector<std::unique_ptr<Mesh>> meshes;
+
+    for (const Part& part : model->parts) {
+        if constexpr (std::is_same_v<V, Vertex>) {
+            meshes.push_back(std::make_unique<Mesh>(part.vertices, part.indices, arena));
+        } else {
+            meshes.push_back(std::make_unique<Mesh>(V::pack(part.vertices), part.indices, arena));
+        }
+    }
+
+    return meshes;
+}
+
+template <typename V>
+bool ModelImporter::write_mesh_file(const char* path, const Model* model, const MeshSimplifier::Settings* lod_settings, const char* source_path) {
+    std::vector<V> vertices;
+    std::vector<GLuint> indices;
+    std::vector<MeshFile::Submesh> submeshes;
+    std::vector<MeshSimplifier::Level> lods;
+    std::vector<MeshletSet::Meshlet> meshlets;
+
+    for (const Part& part : model->parts) {
+        std::vector<V> part_vertices;
+        if constexpr (std::is_same_v<V, Vertex>) {
+            part_vertices = part.vertices;
+        } else {
+            part_vertices = V::pack(part.vertices);
+        }
+
+        std::vector<GLuint> part_indices = part.indices;
+        MeshOptimizer::optimize(&part_vertices, &part_indices);
+        MeshSimplifier::Chain chain = MeshSimplifier::build_lods(part_vertices, part_indices, lod_settings);
+
+        // lod 0 is reordered cluster by cluster, which costs a little of the cache order within it
+        const MeshSimplifier::Level& full = chain.levels[0];
+        std::vector<GLuint> level_indices(chain.indices.begin() + full.first_index, chain.indices.begin() + full.first_index + full.index_count);
+        std::vector<MeshletSet::Meshlet> part_meshlets = MeshletSet::build(
+            chain.indices.data() + full.first_index,
+            level_indices.data(), level_indices.size(),
+            part_vertices.empty() ? nullptr : &part_vertices[0].position.x, sizeof(V),
+            part_vertices.size()
+        );
+
+        MeshFile::Submesh submesh = {};
+        strncpy(submesh.name, part.name.c_str(), sizeof(submesh.name) - 1);
+        submesh.base_vertex = (nstd::U32) vertices.size();
+        submesh.vertex_count = (nstd::U32) part_vertices.size();
+        submesh.first_lod = (nstd::U32) lods.size();
+        submesh.lod_count = (nstd::U32) chain.levels.size();
+        submesh.first_meshlet = (nstd::U32) meshlets.size();
+        submesh.meshlet_count = (nstd::U32) part_meshlets.size();
+        submesh.cache_stats = MeshOptimizer::analyze(chain.indices.data() + full.first_index, full.index_count, part_vertices.size());
+
+        for (int k = 0; k < 3; k++) {
+            submesh.bounds_min[k] = part_vertices.empty() ? 0.0f : part_vertices[0].position[k];
+            submesh.bounds_max[k] = submesh.bounds_min[k];
+        }
+
+        for (const V& vertex : part_vertices) {
+            for (int k = 0; k < 3; k++) {
+                submesh.bounds_min[k] = std::min(submesh.bounds_min[k], vertex.position[k]);
+                submesh.bounds_max[k] = std::max(submesh.bounds_max[k], vertex.position[k]);
+            }
+        }
+
+        for (const MeshSimplifier::Level& level : chain.levels) {
+            lods.push_back({ (nstd::U32) indices.size() + level.first_index, level.index_count, level.error });
+        }
+
+        for (MeshletSet::Meshlet& meshlet : part_meshlets) {
+            meshlet.first_index += (nstd::U32) indices.size() + full.first_index;
+        }
+
+        submeshes.push_back(submesh);
+        meshlets.insert(meshlets.end(), part_meshlets.begin(), part_meshlets.end());
+        vertices.insert(vertices.end(), part_vertices.begin(), part_vertices.end());
+        indices.insert(indices.end(), chain.indices.begin(), chain.indices.end());
+    }
+
+    return MeshFile::write(
+        path, MeshFile::format_of<V>(), sizeof(V), 
+        vertices.data(), (nstd::U32) vertices.size(), 
+        indices.data(), (nstd::U32) indices.size(), 
+        submeshes.data(), (nstd::U32) submeshes.size(), 
+        lods.data(), (nstd::U32) lods.size(),
+        meshlets.data(), (nstd::U32) meshlets.size(),
+        source_path
+    );
+}
+
+#endif
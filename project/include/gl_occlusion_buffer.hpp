@@ -0,0 +1,99 @@
+#ifndef _GL_OCCLUSION_BUFFER_HPP
+#define _GL_OCCLUSION_BUFFER_HPP
+
+// small cpu depth buffer that low poly occluders are rasterized into every frame, objects whose
+// bounds lie behind it are hidden and skipped before submission. rows are split between workers
+// in bands of whole tiles and each tile keeps its farthest depth for a conservative early reject.
+// occluders only cover pixels they cover whole, at the farthest depth over the pixel
+struct OcclusionBuffer {
+    static constexpr int default_width = 256;
+    static constexpr int default_height = 128;
+
+    // pixels per side of a hierarchy tile, the width is padded to a multiple of it
+    static constexpr int tile_size = 8;
+
+    // occluder polygons below this many per worker are rasterized on the calling thread
+    static constexpr size_t min_parallel_polygons = 256;
+
+    // an occluder mesh, positions are read through a stride so any vertex format works
+    typedef struct {
+        const nstd::U8* vertices;
+        size_t stride;
+        size_t vertex_count;
+        const GLuint* indices;
+        size_t index_count;
+        glm::mat4 model;
+    } Occluder;
+
+    // a convex polygon in screen space, z is depth in [0, 1]. two triangles sharing an edge are
+    // merged into a quad of triangles (0, 1, 3) and (1, 2, 3) so pixels on their diagonal are covered
+    typedef struct {
+        float x[4];
+        float y[4];
+        float z[4];
+        int count;
+    } Polygon;
+
+    typedef struct {
+        nstd::U32 occluder_triangles;   // triangles rasterized
+        nstd::U32 tested;               // bounds tested
+        nstd::U32 hidden;               // bounds found hidden
+    } Stats;
+
+    int width;
+    int height;
+    int tiles_x;
+    int tiles_y;
+
+    std::vector<float> depth;       // nearest occluder depth per pixel, 1 where nothing was drawn
+    std::vector<float> tile_depth;  // farthest depth in each tile
+
+    glm::mat4 view_projection;
+    float min_w;                    // clip space w of the near plane, closer points cross it
+    std::vector<Occluder> occluders;
+    std::vector<Polygon> polygons;
+
+    mutable Stats last_frame;
+    mutable Stats frame;
+
+    // create an empty buffer
+    OcclusionBuffer();
+
+    // secondary intialization, the width is padded to whole tiles
+    void init(int width = default_width, int height = default_height);
+
+    // drop last frame's occluders and start a frame seen through view_projection, near_plane is
+    // the camera's near distance, the clip space w of points on the near plane
+    void begin_frame(const glm::mat4& view_projection, float near_plane);
+
+    // queue an occluder, its data has to stay alive until rasterize
+    void add_occluder(const void* vertices, size_t stride, size_t vertex_count, const GLuint* indices, size_t index_count, const glm::mat4& model);
+
+    // queue an occluder of any vertex format with a position
+    template <typename V>
+    void add_occluder(const std::vector<V>& vertices, const std::vector<GLuint>& indices, const glm::mat4& model);
+
+    // clear the buffer and rasterize the queued occluders
+    void rasterize(int threads = 0);
+
+    // whether a mesh space box placed by model may be seen past the occluders, boxes
+    // crossing the near plane always are and boxes off screen never are
+    bool visible(const glm::vec3& bounds_min, const glm::vec3& bounds_max, const glm::mat4& model) const;
+
+    // log the last frame's counters
+    void log_stats() const;
+
+private:
+    // rasterize polygons into the rows of tile rows [first_tile_row, last_tile_row)
+    void rasterize_band(int first_tile_row, int last_tile_row);
+};
+
+template <typename V>
+void OcclusionBuffer::add_occluder(const std::vector<V>& vertices, const std::vector<GLuint>& indices, const glm::mat4& model) {
+    add_occluder(
+        vertices.empty() ? nullptr : (const nstd::U8*) vertices.data() + offsetof(V, position), sizeof(V), vertices.size(),
+        indices.data(), indices.size(), model
+    );
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef _GL_RENDER_QUEUE_HPP
+#define _GL_RENDER_QUEUE_HPP
+
+// draws collected over a frame and issued in sort key order, so draws sharing a shader and vertex
+// array run back to back and opaque draws go front to back for early depth rejects
+//
+// opaque key, high to low bits:      pass 2 | shader 10 | vertex array 10 | depth 22
+// transparent key, high to low bits: pass 2 | inverted depth 22 | shader 10 | vertex array 10
+struct RenderQueue {
+    static constexpr int pass_bits = 2;
+    static constexpr int state_bits = 10;
+    static constexpr int depth_bits = 22;
+
+    typedef enum {
+        QUEUE_PASS_OPAQUE,
+        QUEUE_PASS_TRANSPARENT,
+        QUEUE_PASS_MAX,
+    } Pass;
+
+    typedef struct {
+        Mesh* mesh;
+        const ShaderProgram* shader;
+        const SceneObject* binding;
+        int lod;
+    } Item;
+
+    // program switches of a submit, meshes bind their own vertex arrays so only the grouping is ours
+    typedef struct {
+        nstd::U32 draws;
+        nstd::U32 shader_changes;
+    } Stats;
+
+    std::vector<Item> items;
+    std::vector<nstd::Sort::KeyIndex> keys;
+    std::vector<nstd::Sort::KeyIndex> scratch;
+
+    Stats last_frame;
+
+    // create an empty queue
+    RenderQueue();
+
+    // drop the draws of the last frame
+    void clear();
+
+    // queue a draw, depth is the distance from camera to binding. gl object names only fill the key's
+    // low bits, names that collide still draw correctly but may not be grouped
+    void add(
+        Pass pass,
+        Mesh* mesh,
+        const ShaderProgram* shader,
+        const SceneObject* binding,
+        const Camera* camera,
+        int lod = 0
+    );
+
+    // sort and issue the frame's draws, programs keep their uniforms so per frame uniforms have to be
+    // set on every queued shader beforehand
+    void submit();
+
+    // log the last submit's draws and program switches
+    void log_stats() const;
+
+private:
+    // vertex array a mesh draws from
+    static GLuint vertex_array_of(const Mesh* mesh);
+};
+
+#endif
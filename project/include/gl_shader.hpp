@@ -6,29 +6,79 @@ struct ShaderProgram {
 
     typedef enum {
         PRGM_UNLINKED,
+        PRGM_PENDING,
         PRGM_LINKED,
+        PRGM_FAILED,
     } ProgramStatus;
 
+    // set when the driver compiles and links off the calling thread
+    static bool parallel_compile;
+
+    // without parallel_compile, polls a pending program is left alone for before its link status is queried
+    static constexpr int blind_polls = 8;
+
     GLuint id;
     GLuint shaders[max_shaders];
+    GLenum shader_types[max_shaders];
+    // stage sources, only held between add and submit
+    ShaderSource::Expanded sources[max_shaders];
+
+    // every file the stages were built from, includes too
+    std::vector<std::string> files;
     int num_shaders;
     ProgramStatus status;
 
+    // cache a pending link is stored to once it finishes
+    const ShaderCache* pending_cache;
+    nstd::U64 pending_key;
+
+    // polls since the link was submitted
+    int pending_polls;
+
+    // uniform locations keyed by interned name, cleared on link
+    mutable std::unordered_map<nstd::U32, GLint> uniform_locations;
+
     // create a shader program
     ShaderProgram();
 
     // free up a shader program
     ~ShaderProgram();
 
-    // add and compile a shader to a shader program via the file path
-    void add(const char* path);
+    // add a shader stage to a shader program via the file path, compiled on link
+    void add(const char* path, const char* defines = nullptr);
+
+    // enables driver side parallel compilation when available, call once after loading gl
+    static void init_parallel_compile();
+
+    // compile and link a shader program, or load it from the cache when given one
+    void link(const ShaderCache* cache = nullptr);
+
+    // start compiling and linking without waiting on the driver, the result is picked up by poll or finish
+    void submit(const ShaderCache* cache = nullptr);
+
+    // checks a pending program, returns whether it is linked. only non blocking with
+    // parallel_compile, otherwise the link status is queried after blind_polls calls and
+    // that query still waits if the driver has not finished by then
+    bool poll();
+
+    // waits for a pending program, returns whether it is linked
+    bool finish();
 
-    // link a shader program for after shaders have been added
-    void link();
+    // whether the program is linked and can be activated
+    bool ready() const;
+
+    // exchange gl objects and state with another program, used to swap in a reloaded program
+    void swap(ShaderProgram* other);
+
+    // cache key of the added stage sources
+    nstd::U64 get_cache_key(const ShaderCache* cache) const;
 
     // use a compiled and linked shader program
     void activate() const;
 
+    // get a uniform location by interned name, queried once per link
+    GLint get_uniform_location(nstd::U32 name) const;
+
     /*
         for setting uniforms
     */
@@ -48,6 +98,23 @@ struct ShaderProgram {
     // set 4fv matrix uniform
     void set_uniform_matrix_4fv(const char* name, const GLfloat* uni) const;
 
+    /*
+        for setting uniforms by interned name
+    */
+
+    void set_uniform_1i(nstd::U32 name, const GLint uni) const;
+
+    void set_uniform_1f(nstd::U32 name, const GLfloat data) const;
+
+    void set_uniform_4fv(nstd::U32 name, const GLfloat* uni) const;
+
+    void set_uniform_3fv(nstd::U32 name, const GLfloat* uni) const;
+
+    void set_uniform_matrix_4fv(nstd::U32 name, const GLfloat* uni) const;
+
+private:
+    // drops the views into the source cache once gl has its own copy
+    void release_sources();
 
 };
 
@@ -0,0 +1,47 @@
+#ifndef _GL_SHADER_CACHE_HPP
+#define _GL_SHADER_CACHE_HPP
+
+struct ShaderCache {
+    static constexpr const char* default_dir = "shader_cache";
+    static constexpr nstd::U32 file_magic = 0x48435053; // "SPCH"
+    static constexpr nstd::U32 file_version = 1;
+
+    // header written in front of every cached program binary
+    typedef struct {
+        nstd::U32 magic;
+        nstd::U32 version;
+        nstd::U64 key;
+        GLenum format;
+        GLint length;
+    } FileHeader;
+
+    char dir[256];
+    nstd::U64 driver_hash;
+    bool enabled;
+
+    // create a cache rooted at a directory
+    ShaderCache(const char* dir = default_dir);
+
+    // destroy a cache
+    ~ShaderCache();
+
+    // secondary intialization, needs a current gl context
+    void init();
+
+    // folds bytes into a 64 bit cache key
+    static nstd::U64 hash(nstd::U64 key, const void* bytes, size_t len);
+
+    // key seeded with the driver vendor, renderer and version
+    nstd::U64 base_key() const;
+
+    // load a linked program binary, returns false on miss or when the driver rejects it
+    bool load(GLuint program, nstd::U64 key) const;
+
+    // save the binary of a linked program
+    void store(GLuint program, nstd::U64 key) const;
+
+private:
+    void get_path(nstd::U64 key, char* buf, size_t len) const;
+};
+
+#endif
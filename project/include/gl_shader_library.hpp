@@ -0,0 +1,85 @@
+#ifndef _GL_SHADER_LIBRARY_HPP
+#define _GL_SHADER_LIBRARY_HPP
+
+// compiles program variants of a set of stages keyed by a permutation bitmask
+struct ShaderLibrary {
+    static constexpr int max_options = 16;
+
+    // a named permutation option packed into the mask, 1 bit options are plain #defines
+    typedef struct {
+        const char* name;
+        int shift;
+        int bits;
+        nstd::U32 max_value;    // largest value the shader accepts, at most what fits in bits
+    } Option;
+
+    const char* stages[ShaderProgram::max_shaders];
+    int num_stages;
+
+    Option options[max_options];
+    int num_options;
+    int bits_used;
+
+    // a rebuilt variant waiting to replace the live one
+    typedef struct {
+        ShaderProgram* program;
+        bool fresh;
+    } Reload;
+
+    const ShaderCache* cache;
+    ShaderWatcher* watcher;
+    std::unordered_map<nstd::U32, ShaderProgram*> variants;
+    std::unordered_map<nstd::U32, Reload> reloads;
+
+    // create a shader library, linked variants go through the cache when given one
+    ShaderLibrary(const ShaderCache* cache = nullptr);
+
+    // destroys every compiled variant
+    ~ShaderLibrary();
+
+    // add a shader stage shared by all variants
+    void add_stage(const char* path);
+
+    // add a permutation option, returns its index. max_value caps it below what
+    // the bits could hold, 0 leaves it at the bit limit
+    int add_option(const char* name, int bits = 1, nstd::U32 max_value = 0);
+
+    // mask bits selecting value for an option, clamped to the option's max value
+    nstd::U32 option_bits(int option, nstd::U32 value) const;
+
+    // writes the #define block for a permutation mask
+    void get_defines(nstd::U32 mask, std::string* out) const;
+
+    // submits a variant for compilation without waiting on it
+    ShaderProgram* request(nstd::U32 mask);
+
+    // returns the program for a mask, waiting for it to compile if needed
+    ShaderProgram* get(nstd::U32 mask);
+
+    // returns the program for a mask if it is linked, otherwise requests it and returns fallback
+    ShaderProgram* get_ready(nstd::U32 mask, ShaderProgram* fallback = nullptr);
+
+    // picks up finished variants and swaps in linked reloads, call at a frame boundary
+    // returns how many programs are still compiling
+    int poll();
+
+    // whether any stage or variant was built from a file
+    bool depends_on(const std::string& path) const;
+
+    // watch every stage and every file the variants were built from, variants
+    // built later add their includes to the same watcher
+    void watch(ShaderWatcher* watcher);
+
+    // rebuild every variant in the background, live programs keep drawing until their
+    // replacement links and are then updated in place so held pointers stay valid
+    void reload();
+
+private:
+    // create and submit a variant
+    ShaderProgram* build(nstd::U32 mask);
+
+    // add the files a program was built from to the watcher, if there is one
+    void watch_files(const ShaderProgram* program) const;
+};
+
+#endif
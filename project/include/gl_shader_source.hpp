@@ -0,0 +1,91 @@
+#ifndef _GL_SHADER_SOURCE_HPP
+#define _GL_SHADER_SOURCE_HPP
+
+// shader front end, resolves #include "file" and injects #defines
+// files are mapped once and shared by every program and variant that uses them
+struct ShaderSource {
+    static constexpr int max_include_depth = 16;
+    static constexpr nstd::U32 pack_magic = 0x4B415053; // "SPAK"
+    static constexpr nstd::U32 pack_version = 1;
+    static constexpr int pack_path_len = 112;
+
+    // header at the start of a shader pack
+    typedef struct {
+        nstd::U32 magic;
+        nstd::U32 version;
+        nstd::U32 count;
+        nstd::U32 reserved;
+    } PackHeader;
+
+    // one file of a shader pack, offset is from the start of the pack
+    typedef struct {
+        char path[pack_path_len];
+        nstd::U64 offset;
+        nstd::U64 size;
+    } PackEntry;
+
+    // a file in the source cache, owned mapping or a range of a mounted pack
+    typedef struct {
+        MappedFile* mapping;
+        const char* data;
+        size_t size;
+    } File;
+
+    // a run of stage source with an explicit length, not null terminated
+    typedef struct {
+        const char* data;
+        GLint length;
+    } Segment;
+
+    // preprocessed stage source, segments point into cached files or generated text
+    struct Expanded {
+        std::vector<Segment> segments;
+        std::deque<std::string> generated;
+
+        // append a run of a cached file
+        void add(const char* data, size_t length);
+
+        // append text owned by the expansion
+        void add_generated(std::string text, bool front = false);
+
+        // total source length
+        size_t length() const;
+
+        // drop all segments
+        void clear();
+    };
+
+    // preprocess a shader file, defines are placed after the #version line
+    // paths gets every file read, the stage file first
+    static bool load(const char* path, const char* defines, Expanded* out, std::vector<std::string>* paths = nullptr);
+
+    // get a cached file, mapping it the first time it is opened
+    static const File* open(const char* path);
+
+    // serve files from a pack, files already opened keep their mapping
+    static bool mount_pack(const char* path);
+
+    // write files into a pack that can be mounted instead of the loose files
+    static bool write_pack(const char* pack_path, const char* const* paths, int count);
+
+    // drop the cached mapping of a changed file so the next load reads it again
+    static void invalidate(const char* path);
+
+    // unmap every cached file and pack
+    static void release();
+
+private:
+    static std::mutex lock;
+    static std::unordered_map<std::string, File> files;
+    static std::vector<MappedFile*> packs;
+
+    static bool expand(
+        const char* path, 
+        const char** defines,
+        int depth, 
+        std::vector<std::string>* included, 
+        Expanded* out
+    );
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _GL_SHADER_WATCHER_HPP
+#define _GL_SHADER_WATCHER_HPP
+
+// polls shader files for changes by size and modification time
+struct ShaderWatcher {
+    static constexpr double default_interval = 0.25;
+
+    // a watched file and its stamp when it was last seen changing
+    typedef struct {
+        std::string path;
+        FileStamp stamp;
+    } WatchedFile;
+
+    std::vector<WatchedFile> files;
+    double interval;
+    double last_poll;
+
+    // create a watcher that stats its files at most once per interval seconds
+    ShaderWatcher(double interval = default_interval);
+
+    // start watching a file, files already watched are ignored
+    void watch(const std::string& path);
+
+    // checks the files if the interval has passed, returns whether any changed
+    bool poll(double time, std::vector<std::string>* changed);
+};
+
+#endif
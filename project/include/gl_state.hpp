@@ -0,0 +1,95 @@
+#ifndef _GL_STATE_HPP
+#define _GL_STATE_HPP
+
+// shadows bound gl objects and drops binds that would not change state
+struct GLState {
+    static constexpr GLuint unknown = 0xFFFFFFFF;
+    static constexpr int max_texture_units = 32;
+
+    typedef enum {
+        GLCALL_USE_PROGRAM,
+        GLCALL_BIND_VERTEX_ARRAY,
+        GLCALL_BIND_BUFFER,
+        GLCALL_ACTIVE_TEXTURE,
+        GLCALL_BIND_TEXTURE,
+        GLCALL_MAX,
+    } CallType;
+
+    static constexpr const char* call_str[GLCALL_MAX] = {
+        [GLCALL_USE_PROGRAM] = "glUseProgram",
+        [GLCALL_BIND_VERTEX_ARRAY] = "glBindVertexArray",
+        [GLCALL_BIND_BUFFER] = "glBindBuffer",
+        [GLCALL_ACTIVE_TEXTURE] = "glActiveTexture",
+        [GLCALL_BIND_TEXTURE] = "glBindTexture",
+    };
+
+    // issued and skipped calls per call type
+    typedef struct {
+        nstd::U32 issued[GLCALL_MAX];
+        nstd::U32 skipped[GLCALL_MAX];
+    } Counters;
+
+    static GLuint program;
+    static GLuint vertex_array;
+    static GLuint array_buffer;
+    static GLuint element_buffer;     // part of vertex array state, unknown after a vertex array switch
+    static GLuint uniform_buffer;
+    static GLuint storage_buffer;
+    static GLuint indirect_buffer;
+    static GLenum active_unit;
+    static GLuint textures[max_texture_units];
+
+    static Counters frame;            // counters of the frame in progress
+    static Counters last_frame;       // counters of the last finished frame
+
+    // forget all shadowed state, call once the context is current and after gl calls that bypass the tracker
+    static void reset();
+
+    // close the current frame's counters and start new ones
+    static void begin_frame();
+
+    // log the last frame's counters
+    static void log_last_frame();
+
+    // glUseProgram if program is not current
+    static void use_program(GLuint id);
+
+    // glBindVertexArray if the vertex array is not bound
+    static void bind_vertex_array(GLuint id);
+
+    // glBindBuffer if the buffer is not bound to target
+    static void bind_buffer(GLenum target, GLuint id);
+
+    // glBindBufferBase, always issued since indexed bindings are not shadowed, updates the generic binding
+    static void bind_buffer_base(GLenum target, GLuint index, GLuint id);
+
+    // glBindBufferRange, always issued like bind_buffer_base
+    static void bind_buffer_range(GLenum target, GLuint index, GLuint id, size_t offset, size_t size);
+
+    // glActiveTexture if unit (GL_TEXTUREi) is not active
+    static void active_texture(GLenum unit);
+
+    // binds a 2d texture to a unit (GL_TEXTUREi) if it is not already bound there
+    static void bind_texture(GLenum unit, GLuint id);
+
+    // binds a 2d texture to the active unit
+    static void bind_texture(GLuint id);
+
+    /*
+        gl drops bindings of deleted objects, keep the shadow in sync
+    */
+
+    static void on_delete_program(GLuint id);
+
+    static void on_delete_vertex_array(GLuint id);
+
+    static void on_delete_buffer(GLuint id);
+
+    static void on_delete_texture(GLuint id);
+
+private:
+    static GLuint* get_buffer_binding(GLenum target);
+    static bool filter(CallType type, GLuint* shadow, GLuint value);
+};
+
+#endif
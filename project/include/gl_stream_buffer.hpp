@@ -0,0 +1,76 @@
+#ifndef _GL_STREAM_BUFFER_HPP
+#define _GL_STREAM_BUFFER_HPP
+
+// buffer for data rewritten every frame, split into regions used round robin. each region is
+// fenced when its frame is submitted and only written again once the gpu passed the fence, so
+// writes go straight into persistently mapped memory without reallocation or implicit syncs
+struct StreamBuffer {
+    static constexpr int default_regions = 3;
+    static constexpr int max_regions = 4;
+
+    // regions start on this boundary so region relative alignment holds in the buffer
+    static constexpr size_t region_alignment = 256;
+
+    // longest a region's fence is waited on before the wait is given up
+    static constexpr GLuint64 max_wait_ns = 1000000000;
+
+    GLenum target;
+    GLuint id;
+
+    size_t region_size;
+    int region_count;
+    int region;             // region written this frame
+    size_t offset;          // write cursor within the region
+    size_t flushed;         // end of the part of the region uploaded without buffer storage
+
+    nstd::U8* mapped;       // persistent mapping, or staging memory without buffer storage
+    bool persistent;
+    GLsync fences[max_regions];
+
+    // create a stream buffer
+    StreamBuffer();
+
+    // unmap and destroy a stream buffer
+    ~StreamBuffer();
+
+    // secondary intialization, region_size bytes are available per frame
+    void init(GLenum target, size_t region_size, int regions = default_regions);
+
+    // whether the driver has glBufferStorage, without it regions are uploaded with glBufferSubData
+    static bool supported();
+
+    // move to the next region, waits if the gpu still reads it
+    void begin_frame();
+
+    // reserve size bytes in the current region, returns nullptr if the region is full
+    // offset receives the byte offset in the buffer to bind or draw from
+    void* alloc(size_t size, size_t alignment, size_t* offset);
+
+    // copy data into the current region, returns its byte offset or -1 if the region is full
+    ptrdiff_t write(const void* data, size_t size, size_t alignment = 4);
+
+    // make the writes so far visible to draws, only uploads without buffer storage
+    void flush();
+
+    // fence the current region, called after the frame's last draw reading it
+    void end_frame();
+
+    // make room for region_size bytes per frame, reallocating after all regions are idle,
+    // data written this frame is lost when it grows
+    void reserve(size_t region_size);
+
+    // bind to the buffer's target
+    void bind() const;
+
+private:
+    // create and map storage for the current region size and count
+    void create();
+
+    // unmap and delete the storage, waiting on every region
+    void destroy();
+
+    // wait for and drop a region's fence, returns false if it did not signal in max_wait_ns
+    bool wait(int region);
+};
+
+#endif
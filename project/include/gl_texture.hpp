@@ -45,7 +45,7 @@ struct Texture {
     // pass texture unit to shader
     void assign_unit(const ShaderProgram* shader, const char* uni) const;
 
-    // unbinds all textures
+    // unbinds the texture on the active unit
     static void unbind();
 };
 
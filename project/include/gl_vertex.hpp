@@ -1,6 +1,64 @@
 #ifndef _GL_VERTEX_HPP
 #define _GL_VERTEX_HPP
 
+/*
+    packed attribute components
+*/
+
+// two half floats, for texture coordinates
+struct Half2 {
+    nstd::U16 x;
+    nstd::U16 y;
+
+    static Half2 pack(glm::vec2 v);
+};
+
+// signed normalized 10-10-10-2, for normals, w is unused
+struct PackedNormal {
+    nstd::U32 bits;
+
+    static PackedNormal pack(glm::vec3 n);
+};
+
+// four unsigned normalized bytes, for colors
+struct Unorm8x4 {
+    nstd::U8 r;
+    nstd::U8 g;
+    nstd::U8 b;
+    nstd::U8 a;
+
+    static Unorm8x4 pack(glm::vec4 c);
+};
+
+// gl component count, type and normalization of an attribute member type
+template <typename T> struct AttributeFormat;
+
+template <> struct AttributeFormat<float> { static constexpr int size = 1; static constexpr GLenum type = GL_FLOAT; static constexpr bool normalized = false; };
+template <> struct AttributeFormat<glm::vec2> { static constexpr int size = 2; static constexpr GLenum type = GL_FLOAT; static constexpr bool normalized = false; };
+template <> struct AttributeFormat<glm::vec3> { static constexpr int size = 3; static constexpr GLenum type = GL_FLOAT; static constexpr bool normalized = false; };
+template <> struct AttributeFormat<glm::vec4> { static constexpr int size = 4; static constexpr GLenum type = GL_FLOAT; static constexpr bool normalized = false; };
+template <> struct AttributeFormat<Half2> { static constexpr int size = 2; static constexpr GLenum type = GL_HALF_FLOAT; static constexpr bool normalized = false; };
+template <> struct AttributeFormat<PackedNormal> { static constexpr int size = 4; static constexpr GLenum type = GL_INT_2_10_10_10_REV; static constexpr bool normalized = true; };
+template <> struct AttributeFormat<Unorm8x4> { static constexpr int size = 4; static constexpr GLenum type = GL_UNSIGNED_BYTE; static constexpr bool normalized = true; };
+
+// attribute of a vertex member at a shader location, type and offset come from the member
+#define VERTEX_ATTRIBUTE(vertex, member, location) VertexArray::Attribute { \
+    location, \
+    AttributeFormat<decltype(vertex::member)>::size, \
+    AttributeFormat<decltype(vertex::member)>::type, \
+    AttributeFormat<decltype(vertex::member)>::normalized, \
+    sizeof(vertex), \
+    offsetof(vertex, member) \
+}
+
+// attribute list of a vertex format, specialized per format below
+template <typename V> struct VertexLayout;
+
+/*
+    vertex formats, shader locations are position 0, normal 1, color 2, uv 3
+*/
+
+// full precision vertex, 48 bytes
 struct Vertex {
     glm::vec3 position;
     glm::vec3 normal;
@@ -8,4 +66,55 @@ struct Vertex {
     glm::vec2 texUV;
 };
 
-#endif
\ No newline at end of file
+// packed vertex, 24 bytes
+struct VertexCompact {
+    glm::vec3 position;
+    PackedNormal normal;
+    Unorm8x4 color;
+    Half2 texUV;
+
+    // pack a full precision vertex
+    static VertexCompact pack(const Vertex& v);
+
+    // pack a list of full precision vertices
+    static std::vector<VertexCompact> pack(const std::vector<Vertex>& vertices);
+};
+
+// position only vertex, 12 bytes
+struct VertexPosition {
+    glm::vec3 position;
+};
+
+template <> struct VertexLayout<Vertex> {
+    static constexpr VertexArray::Attribute attributes[] = {
+        VERTEX_ATTRIBUTE(Vertex, position, 0),
+        VERTEX_ATTRIBUTE(Vertex, normal, 1),
+        VERTEX_ATTRIBUTE(Vertex, color, 2),
+        VERTEX_ATTRIBUTE(Vertex, texUV, 3),
+    };
+
+    static constexpr int count = sizeof(attributes) / sizeof(attributes[0]);
+};
+
+template <> struct VertexLayout<VertexCompact> {
+    static constexpr VertexArray::Attribute attributes[] = {
+        VERTEX_ATTRIBUTE(VertexCompact, position, 0),
+        VERTEX_ATTRIBUTE(VertexCompact, normal, 1),
+        VERTEX_ATTRIBUTE(VertexCompact, color, 2),
+        VERTEX_ATTRIBUTE(VertexCompact, texUV, 3),
+    };
+
+    static constexpr int count = sizeof(attributes) / sizeof(attributes[0]);
+};
+
+template <> struct VertexLayout<VertexPosition> {
+    static constexpr VertexArray::Attribute attributes[] = {
+        VERTEX_ATTRIBUTE(VertexPosition, position, 0),
+    };
+
+    static constexpr int count = sizeof(attributes) / sizeof(attributes[0]);
+};
+
+static_assert(sizeof(VertexCompact) == 24, "VertexCompact has padding");
+
+#endif
@@ -11,15 +11,9 @@ struct VertexArray {
         const GLenum type;
         const bool normalized;
         const int stride;
-        const void* offset;
+        const size_t offset;
     } Attribute;
 
-    // predefined vertex attributes
-    static const Attribute vertex_position_attribute;
-    static const Attribute vertex_normal_attribute;
-    static const Attribute vertex_color_attribute;
-    static const Attribute vertex_texUV_attribute;
-
     // create a vertex array
     VertexArray();
 
@@ -37,6 +31,9 @@ struct VertexArray {
 
     // add attribute to vertex array
     void add_attribute(const Attribute attribute) const;
+
+    // add a list of attributes, usually VertexLayout<V>::attributes
+    void add_attributes(const Attribute* attributes, int count) const;
 };
 
 #endif
\ No newline at end of file
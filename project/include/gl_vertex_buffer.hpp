@@ -13,6 +13,9 @@ struct VertexBuffer {
     // generate vertex buffer
     void init(const std::vector<Vertex>& vertice);
 
+    // generate vertex buffer from raw vertex data of any format
+    void init(const void* data, size_t size);
+
     // bind as current vertex buffer
     void bind() const;
 
@@ -0,0 +1,62 @@
+#ifndef _GL_VERTEX_WELDER_HPP
+#define _GL_VERTEX_WELDER_HPP
+
+// turns unindexed triangle soups into unique vertices and an index buffer by hashing whole
+// vertices, large inputs are split across threads by hash so the result does not depend on them
+struct VertexWelder {
+    // inputs below this many vertices per worker are welded on the calling thread
+    static constexpr size_t min_parallel_vertices = 1 << 16;
+
+    // maps each input vertex to its unique vertex, unique vertices are numbered by first occurrence.
+    // vertices compare bytewise, so vertex types must not have padding, only -0.0 in the position
+    // is made equal to 0.0. with an epsilon the three floats at position_offset are snapped to a
+    // grid of that size first: it is not a distance, two vertices closer than epsilon on either
+    // side of a cell boundary stay apart. returns the unique count
+    static size_t generate_remap(
+        GLuint* remap,
+        const void* vertices,
+        size_t vertex_count,
+        size_t vertex_size,
+        size_t position_offset = 0,
+        float epsilon = 0.0f,
+        int threads = 0
+    );
+
+    // welds a soup of vertex_count vertices into unique vertices and one index per input vertex,
+    // the first vertex of each welded group is kept
+    template <typename V>
+    static size_t weld(
+        const V* soup,
+        size_t vertex_count,
+        std::vector<V>* vertices,
+        std::vector<GLuint>* indices,
+        float epsilon = 0.0f,
+        int threads = 0
+    );
+};
+
+template <typename V>
+size_t VertexWelder::weld(
+    const V* soup,
+    size_t vertex_count,
+    std::vector<V>* vertices,
+    std::vector<GLuint>* indices,
+    float epsilon,
+    int threads
+) {
+    indices->resize(vertex_count);
+    size_t unique = generate_remap(indices->data(), soup, vertex_count, sizeof(V), offsetof(V, position), epsilon, threads);
+
+    // unique vertices appear in order of their first occurrence
+    vertices->clear();
+    vertices->reserve(unique);
+    for (size_t i = 0; i < vertex_count; i++) {
+        if ((*indices)[i] == vertices->size()) {
+            vertices->push_back(soup[i]);
+        }
+    }
+
+    return unique;
+}
+
+#endif
@@ -10,6 +10,15 @@
 #include <map>
 #include <algorithm>
 #include <unordered_map>
+#include <deque>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <semaphore>
+#include <cfloat>
+#include <filesystem>
 
 #include "glad/glad.h"
 #include <GL/gl.h>
@@ -20,6 +29,9 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <stb/stb_image.h>
 
+#include "nstd.hpp"
+#include "parallel.hpp"
+
 #define check_alloc(ptr) ({ if (!ptr) LOGE("allocation failed, non mem"); ptr; })
 #define LOGI(fmt, ...) do { printf(fmt "\n", ##__VA_ARGS__); } while (0)
 #define LOGE(fmt, ...) do { fprintf(stderr, fmt "\n", ##__VA_ARGS__); } while (0)
@@ -27,7 +39,13 @@
 #define MIN(T, a, b) ({ T _a = a; T _b = b; (_a < _b) ? _a : _b; })
 #define MAX(T, a, b) ({ T _a = a; T _b = b; (_a < _b) ? _b : _a; })
 
+#include "gl_state.hpp"
+#include "gl_shader_cache.hpp"
+#include "gl_file_map.hpp"
+#include "gl_shader_source.hpp"
 #include "gl_shader.hpp"
+#include "gl_shader_watcher.hpp"
+#include "gl_shader_library.hpp"
 
 // game objects
 #include "scene_object.hpp"
@@ -35,11 +53,22 @@
 #include "scene_light.hpp"
 
 // mesh
+#include "gl_vertex_array.hpp"
 #include "gl_vertex.hpp"
 #include "gl_vertex_buffer.hpp"
 #include "gl_element_buffer.hpp"
-#include "gl_vertex_array.hpp"
+#include "gl_stream_buffer.hpp"
+#include "gl_geometry_arena.hpp"
 #include "gl_texture.hpp"
+#include "gl_mesh_optimizer.hpp"
+#include "gl_vertex_welder.hpp"
+#include "gl_mesh_simplifier.hpp"
+#include "gl_meshlet.hpp"
+#include "gl_mesh_file.hpp"
 #include "gl_mesh.hpp"
+#include "gl_model_importer.hpp"
+#include "gl_draw_list.hpp"
+#include "gl_render_queue.hpp"
+#include "gl_occlusion_buffer.hpp"
 
 #endif
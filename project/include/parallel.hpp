@@ -0,0 +1,41 @@
+#ifndef _PARALLEL_HPP
+#define _PARALLEL_HPP
+
+// splits loops across a pool of worker threads started on first use and kept for the rest of
+// the run, the calling thread takes the first slice and then helps with the others
+struct Parallel {
+    // hardware threads, at least one
+    static int thread_count();
+
+    // worker count for count items when each worker should get at least min_per_worker of them
+    static int worker_count(size_t count, size_t min_per_worker, int threads = 0);
+
+    // runs fn(worker, begin, end) over count items split evenly between workers
+    template <typename F>
+    static void for_range(size_t count, int workers, F fn);
+
+    // runs run(context, slice) for every slice, slice 0 on the calling thread, and returns once all finished
+    static void run_slices(size_t slices, void (*run)(void* context, size_t slice), void* context);
+};
+
+template <typename F>
+void Parallel::for_range(size_t count, int workers, F fn) {
+    size_t slices = nstd::min((size_t) nstd::max((size_t) workers, (size_t) 1), count);
+    if (slices <= 1) {
+        fn(0, 0, count);
+        return;
+    }
+
+    struct Range {
+        F* fn;
+        size_t count;
+        size_t slices;
+    } range = { &fn, count, slices };
+
+    run_slices(slices, [](void* context, size_t slice) {
+        Range* range = (Range*) context;
+        (*range->fn)((int) slice, range->count * slice / range->slices, range->count * (slice + 1) / range->slices);
+    }, &range);
+}
+
+#endif
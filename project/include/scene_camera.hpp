@@ -28,11 +28,18 @@ struct Camera {
     // returns perspective matrix
     glm::mat4 get_perspective() const;
 
-    // passes viewport to a shader
-    void apply_viewport(const ShaderProgram* shader, const char* uniform) const;
+    // frustum planes of a view projection matrix as (normal, distance), normalized and facing inwards,
+    // a point p is inside when dot(normal, p) + distance >= 0 for every plane
+    static void frustum_planes(const glm::mat4& view_projection, float planes[6][4]);
 
-    // passed position to a shader
-    void apply_position(const ShaderProgram* shader, const char* uniform) const;
+    // on screen diameter in pixels of a world space sphere
+    float projected_size(glm::vec3 center, float radius) const;
+
+    // passes viewport to a shader, uniform is an interned name
+    void apply_viewport(const ShaderProgram* shader, nstd::U32 uniform) const;
+
+    // passed position to a shader, uniform is an interned name
+    void apply_position(const ShaderProgram* shader, nstd::U32 uniform) const;
 
     // applies camera movement "WASD"
     void apply_inputs(float dt) const;
@@ -2,6 +2,9 @@
 #define _SCENE_LIGHT_HPP
 
 struct Light {
+    // matches MAX_LIGHTS in lighting.glsl
+    static constexpr int max_lights = 10;
+
     glm::vec4 color;
     float intensity;
     float brightness;
@@ -19,4 +22,30 @@ struct Light {
     void render(const ShaderProgram* shader, const SceneObject* binding, int idx) const;
 };
 
+// the lights of a scene, one array per field so uploading walks each field linearly
+struct LightSet {
+    typedef nstd::SoaArray<glm::vec4, float, float, const SceneObject*> Lights;
+
+    typedef enum {
+        LIGHT_FIELD_COLOR,
+        LIGHT_FIELD_INTENSITY,
+        LIGHT_FIELD_BRIGHTNESS,
+        LIGHT_FIELD_BINDING,
+    } LightField;
+
+    Lights* lights;
+
+    LightSet();
+
+    ~LightSet();
+
+    // copy a light bound to an object into the set, returns its index or -1 when full
+    int add(const Light& light, const SceneObject* binding);
+
+    int count() const;
+
+    // upload every light to shader
+    void apply(const ShaderProgram* shader) const;
+};
+
 #endif
\ No newline at end of file
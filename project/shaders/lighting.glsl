@@ -0,0 +1,46 @@
+struct Light {
+    vec4 Color;
+    vec3 Position;
+    float Intensity;
+    float Brightness;
+};
+
+// matches Light::max_lights
+#define MAX_LIGHTS 10
+
+uniform Light lights[MAX_LIGHTS];
+
+// LIGHT_COUNT fixes the loop bound so the compiler can unroll it
+#ifdef LIGHT_COUNT
+#if LIGHT_COUNT > MAX_LIGHTS
+#error LIGHT_COUNT is larger than the lights array
+#endif
+const int numLights = LIGHT_COUNT;
+#else
+uniform int numLights;
+#endif
+
+vec4 shadeLights(vec3 position, vec3 normal, vec3 cameraPosition, vec4 texColor, vec4 specColor) {
+    const float ambient = 0.3f;
+    const float specularLight = 0.1f;
+
+    vec4 finalColor = vec4(0.0);
+    vec3 viewDirection = normalize(cameraPosition - position);
+
+    for (int i = 0; i < numLights; i++) {
+        vec3 lightDirection = normalize(lights[i].Position - position);
+        float diffuse = max(dot(normal, lightDirection), 0.0) * lights[i].Intensity;
+
+#ifdef NO_SPECULAR
+        float specular = 0.0f;
+#else
+        vec3 reflectionDirection = reflect(-lightDirection, normal);
+        float specAmount = pow(max(dot(viewDirection, reflectionDirection), 0.0f), 16);
+        float specular = specAmount * specularLight;
+#endif
+
+        finalColor += ((diffuse + ambient) * texColor + specular * specColor.r) * lights[i].Color * lights[i].Brightness;
+    }
+
+    return finalColor;
+}
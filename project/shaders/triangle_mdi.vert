@@ -0,0 +1,36 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec4 aColor;
+layout(location = 3) in vec2 aTex;
+
+// matches DrawList::ObjectData
+struct ObjectData {
+    mat4 model;
+    vec4 bounds;
+    uint material;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+uniform mat4 view;
+uniform float texTileCount = 1;
+
+out vec3 iNormal;
+out vec3 iPosition;
+out vec4 iColor;
+out vec2 iTexCoord;
+
+void main() {
+    mat4 model = objects[gl_BaseInstanceARB + gl_InstanceID].model;
+
+    iColor = aColor;
+    iTexCoord = aTex * texTileCount;
+    iPosition = vec3(model * vec4(aPosition, 1.0));
+    iNormal = aNormal;
+
+    gl_Position = view * model * vec4(aPosition, 1.0);
+}
@@ -0,0 +1,183 @@
+#include "main.hpp"
+
+DrawList::DrawList() {
+    this->arena = nullptr;
+    this->storage_alignment = 256;
+}
+
+DrawList::~DrawList() {}
+
+void DrawList::init(const GeometryArena* arena) {
+    this->arena = arena;
+
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &this->storage_alignment);
+
+    this->command_buffer.init(GL_DRAW_INDIRECT_BUFFER, 256 * sizeof(DrawCommand));
+    this->object_buffer.init(GL_SHADER_STORAGE_BUFFER, 256 * sizeof(ObjectData));
+}
+
+bool DrawList::supported() {
+    // the shader is glsl 430 and reads gl_BaseInstanceARB, 4.6 made draw parameters core
+    // under another name so the extension is needed on every version
+    return GLAD_GL_VERSION_4_3 && GLAD_GL_ARB_shader_draw_parameters;
+}
+
+bool DrawList::culling_supported() {
+    return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_compute_shader;
+}
+
+glm::vec4 DrawList::bounds_of(const Mesh* mesh) {
+    glm::vec3 center = (mesh->bounds_min + mesh->bounds_max) * 0.5f;
+    return glm::vec4(center, glm::length(mesh->bounds_max - mesh->bounds_min) * 0.5f);
+}
+
+void DrawList::clear() {
+    this->commands.clear();
+    this->objects.clear();
+}
+
+void DrawList::add(
+    nstd::U32 handle, 
+    const SceneObject* binding, 
+    nstd::U32 material, 
+    nstd::U32 first_index, 
+    nstd::U32 index_count
+) {
+    const GeometryArena::Allocation* allocation = this->arena->get(handle);
+    if (!allocation) {
+        LOGE("draw list add of invalid handle %u", handle);
+        return;
+    }
+
+    if (first_index > allocation->index_count) {
+        LOGE("draw list add range out of bounds");
+        return;
+    }
+
+    index_count = nstd::min(index_count, allocation->index_count - first_index);
+
+    // base_instance selects the object's entry in the storage buffer
+    this->commands.push_back({
+        .count = index_count,
+        .instance_count = 1,
+        .first_index = allocation->first_index + first_index,
+        .base_vertex = (GLint) allocation->base_vertex,
+        .base_instance = (GLuint) this->objects.size(),
+    });
+
+    this->objects.push_back({
+        .model = binding->get_model_matrix(),
+        .bounds = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f),
+        .material = material,
+        .pad = { 0, 0, 0 },
+    });
+}
+
+void DrawList::add(const Mesh* mesh, const SceneObject* binding, nstd::U32 material, int lod) {
+    if (mesh->arena != this->arena) {
+        LOGE("draw list add of a mesh from another arena");
+        return;
+    }
+
+    size_t count = this->objects.size();
+    const MeshSimplifier::Level& level = mesh->lods[nstd::min((size_t) lod, mesh->lods.size() - 1)];
+    add(mesh->arena_handle, binding, material, level.first_index, level.index_count);
+
+    if (this->objects.size() > count) {
+        this->objects.back().bounds = bounds_of(mesh);
+    }
+}
+
+void DrawList::add(const Mesh* mesh, const SceneObject* binding, const MeshletSet::Range* ranges, size_t count, nstd::U32 material) {
+    const GeometryArena::Allocation* allocation = mesh->arena == this->arena ? this->arena->get(mesh->arena_handle) : nullptr;
+    if (!allocation) {
+        LOGE("draw list add of a mesh from another arena");
+        return;
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    // every range draws with the same base_instance and so the same object entry
+    GLuint base_instance = (GLuint) this->objects.size();
+
+    for (size_t i = 0; i < count; i++) {
+        if ((nstd::U64) ranges[i].first_index + ranges[i].index_count > allocation->index_count) {
+            LOGE("draw list add range out of bounds");
+            continue;
+        }
+
+        this->commands.push_back({
+            .count = ranges[i].index_count,
+            .instance_count = 1,
+            .first_index = allocation->first_index + ranges[i].first_index,
+            .base_vertex = (GLint) allocation->base_vertex,
+            .base_instance = base_instance,
+        });
+    }
+
+    this->objects.push_back({
+        .model = binding->get_model_matrix(),
+        .bounds = bounds_of(mesh),
+        .material = material,
+        .pad = { 0, 0, 0 },
+    });
+}
+
+size_t DrawList::upload(StreamBuffer* buffer, const void* data, size_t size, size_t alignment) {
+    buffer->begin_frame();
+    buffer->reserve(size);
+
+    size_t offset = 0;
+    void* dst = buffer->alloc(size, alignment, &offset);
+    if (dst) {
+        memcpy(dst, data, size);
+    }
+
+    buffer->flush();
+    return offset;
+}
+
+void DrawList::submit(const ShaderProgram* shader, const ShaderProgram* cull_shader, const Camera* camera) {
+    static const nstd::U32 planes_uniform = nstd::StringTable::intern("planes");
+    static const nstd::U32 command_count_uniform = nstd::StringTable::intern("commandCount");
+
+    if (this->commands.empty()) {
+        return;
+    }
+
+    this->arena->bind();
+
+    size_t objects_size = this->objects.size() * sizeof(ObjectData);
+    size_t objects_offset = upload(&this->object_buffer, this->objects.data(), objects_size, this->storage_alignment);
+    GLState::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, object_binding, this->object_buffer.id, objects_offset, objects_size);
+
+    // storage aligned so the cull pass can bind the commands as a storage buffer
+    size_t commands_size = this->commands.size() * sizeof(DrawCommand);
+    size_t commands_offset = upload(&this->command_buffer, this->commands.data(), commands_size, this->storage_alignment);
+
+    if (cull_shader && camera) {
+        float planes[6][4];
+        Camera::frustum_planes(camera->get_perspective(), planes);
+
+        cull_shader->activate();
+        glUniform4fv(cull_shader->get_uniform_location(planes_uniform), 6, &planes[0][0]);
+        cull_shader->set_uniform_1i(command_count_uniform, (GLint) this->commands.size());
+
+        GLState::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, command_binding, this->command_buffer.id, commands_offset, commands_size);
+        glDispatchCompute(((GLuint) this->commands.size() + cull_group_size - 1) / cull_group_size, 1, 1);
+
+        // the draw reads the rewritten commands as indirect arguments
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+    }
+
+    shader->activate();
+    this->command_buffer.bind();
+
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*) commands_offset, (GLsizei) this->commands.size(), 0);
+
+    // regions are written again once the gpu is done with this draw
+    this->object_buffer.end_frame();
+    this->command_buffer.end_frame();
+}
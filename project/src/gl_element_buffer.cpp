@@ -1,21 +1,28 @@
 #include "main.hpp"
 
-ElementBuffer::ElementBuffer() {}
+ElementBuffer::ElementBuffer() {
+    this->id = 0;
+}
 
 ElementBuffer::~ElementBuffer() {
+    GLState::on_delete_buffer(this->id);
     glDeleteBuffers(1, &this->id);
 }
 
 void ElementBuffer::init(const std::vector<GLuint>& data) {
+    init(data.data(), data.size() * sizeof(GLuint));
+}
+
+void ElementBuffer::init(const void* data, size_t size) {
     glGenBuffers(1, &this->id);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->id);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.size() * sizeof(GLuint), data.data(), GL_STATIC_DRAW);
+    GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, this->id);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
 void ElementBuffer::bind() {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->id);
+    GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, this->id);
 }
 
 void ElementBuffer::unbind() {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 } 
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "main.hpp"
+
+#ifdef _WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+    this->data = nullptr;
+    this->size = 0;
+
+#ifdef _WIN32
+    this->file_handle = nullptr;
+    this->mapping_handle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path) {
+    close();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        LOGE("failed to open file %s", path);
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        LOGE("failed to get file stats: %s", path);
+        CloseHandle(file);
+        return false;
+    }
+
+    this->file_handle = file;
+    this->size = (size_t) file_size.QuadPart;
+
+    // empty files can not be mapped, they are returned as a zero length view
+    if (this->size == 0) {
+        this->data = "";
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        LOGE("failed to map file %s", path);
+        close();
+        return false;
+    }
+
+    this->mapping_handle = mapping;
+    this->data = (const char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (!this->data) {
+        LOGE("failed to map file %s", path);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (this->data && this->size) {
+        UnmapViewOfFile(this->data);
+    }
+
+    if (this->mapping_handle) {
+        CloseHandle((HANDLE) this->mapping_handle);
+    }
+
+    if (this->file_handle) {
+        CloseHandle((HANDLE) this->file_handle);
+    }
+
+    this->data = nullptr;
+    this->size = 0;
+    this->file_handle = nullptr;
+    this->mapping_handle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        LOGE("failed to open file %s", path);
+        return false;
+    }
+
+    struct stat file_stats;
+    if (fstat(fd, &file_stats) != 0) {
+        LOGE("failed to get file stats: %s", path);
+        ::close(fd);
+        return false;
+    }
+
+    this->size = (size_t) file_stats.st_size;
+
+    // empty files can not be mapped, they are returned as a zero length view
+    if (this->size == 0) {
+        this->data = "";
+        ::close(fd);
+        return true;
+    }
+
+    void* view = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+
+    if (view == MAP_FAILED) {
+        LOGE("failed to map file %s", path);
+        this->size = 0;
+        return false;
+    }
+
+    this->data = (const char*) view;
+    return true;
+}
+
+void MappedFile::close() {
+    if (this->data && this->size) {
+        munmap((void*) this->data, this->size);
+    }
+
+    this->data = nullptr;
+    this->size = 0;
+}
+
+#endif
+
+/*
+    file stamp
+*/
+
+#ifdef _WIN32
+
+bool FileStamp::get(const char* path, FileStamp* out) {
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes)) {
+        return false;
+    }
+
+    // last write time is kept in 100ns ticks, stat would round it to seconds
+    nstd::U64 ticks = (nstd::U64) attributes.ftLastWriteTime.dwHighDateTime << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+
+    out->size = (nstd::U64) attributes.nFileSizeHigh << 32 | attributes.nFileSizeLow;
+    out->mtime = ticks * 100;
+    return true;
+}
+
+#else
+
+bool FileStamp::get(const char* path, FileStamp* out) {
+    struct stat file_stats;
+    if (stat(path, &file_stats) != 0) {
+        return false;
+    }
+
+    out->size = (nstd::U64) file_stats.st_size;
+
+#ifdef __APPLE__
+    out->mtime = (nstd::U64) file_stats.st_mtimespec.tv_sec * 1000000000ull + file_stats.st_mtimespec.tv_nsec;
+#else
+    out->mtime = (nstd::U64) file_stats.st_mtim.tv_sec * 1000000000ull + file_stats.st_mtim.tv_nsec;
+#endif
+
+    return true;
+}
+
+#endif
+
+bool FileStamp::operator==(const FileStamp& other) const {
+    return this->size == other.size && this->mtime == other.mtime;
+}
+
+bool FileStamp::operator!=(const FileStamp& other) const {
+    return !(*this == other);
+}
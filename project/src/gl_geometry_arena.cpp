@@ -0,0 +1,331 @@
+#include "main.hpp"
+
+/*
+    range list
+*/
+
+void GeometryArena::RangeList::init(nstd::U32 capacity) {
+    this->free_ranges.clear();
+    this->free_ranges[0] = capacity;
+    this->capacity = capacity;
+    this->used = 0;
+}
+
+bool GeometryArena::RangeList::alloc(nstd::U32 count, nstd::U32* offset) {
+    for (auto it = this->free_ranges.begin(); it != this->free_ranges.end(); ++it) {
+        if (it->second < count) {
+            continue;
+        }
+
+        *offset = it->first;
+
+        nstd::U32 remaining = it->second - count;
+        nstd::U32 rest = it->first + count;
+        this->free_ranges.erase(it);
+
+        if (remaining) {
+            this->free_ranges[rest] = remaining;
+        }
+
+        this->used += count;
+        return true;
+    }
+
+    return false;
+}
+
+void GeometryArena::RangeList::free(nstd::U32 offset, nstd::U32 count) {
+    if (count == 0) {
+        return;
+    }
+
+    this->used -= count;
+
+    auto next = this->free_ranges.lower_bound(offset);
+
+    // merge with the following range
+    if (next != this->free_ranges.end() && offset + count == next->first) {
+        count += next->second;
+        next = this->free_ranges.erase(next);
+    }
+
+    // merge with the preceding range
+    if (next != this->free_ranges.begin()) {
+        auto prev = std::prev(next);
+
+        if (prev->first + prev->second == offset) {
+            prev->second += count;
+            return;
+        }
+    }
+
+    this->free_ranges[offset] = count;
+}
+
+void GeometryArena::RangeList::grow(nstd::U32 capacity) {
+    nstd::U32 old_capacity = this->capacity;
+    this->capacity = capacity;
+
+    // counted as used by free so it can merge with a free tail
+    this->used += capacity - old_capacity;
+    free(old_capacity, capacity - old_capacity);
+}
+
+void GeometryArena::RangeList::pack(nstd::U32 used) {
+    this->free_ranges.clear();
+
+    if (used < this->capacity) {
+        this->free_ranges[used] = this->capacity - used;
+    }
+
+    this->used = used;
+}
+
+/*
+    arena
+*/
+
+GeometryArena::GeometryArena() {
+    this->vertex_buffer = 0;
+    this->index_buffer = 0;
+    this->vertex_size = 0;
+}
+
+GeometryArena::~GeometryArena() {
+    GLState::on_delete_buffer(this->vertex_buffer);
+    GLState::on_delete_buffer(this->index_buffer);
+    glDeleteBuffers(1, &this->vertex_buffer);
+    glDeleteBuffers(1, &this->index_buffer);
+}
+
+void GeometryArena::init(
+    GLsizei vertex_size, 
+    const VertexArray::Attribute* attributes, 
+    int num_attributes,
+    nstd::U32 vertex_capacity,
+    nstd::U32 index_capacity
+) {
+    this->vertex_size = vertex_size;
+    // attributes have const members, so they are copy constructed one by one
+    this->attributes.clear();
+    for (int i = 0; i < num_attributes; i++) {
+        this->attributes.push_back(attributes[i]);
+    }
+
+    this->vertex_ranges.init(vertex_capacity);
+    this->index_ranges.init(index_capacity);
+
+    glGenBuffers(1, &this->vertex_buffer);
+    GLState::bind_buffer(GL_ARRAY_BUFFER, this->vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, (size_t) vertex_capacity * vertex_size, nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &this->index_buffer);
+    GLState::bind_buffer(GL_COPY_WRITE_BUFFER, this->index_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (size_t) index_capacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+
+    this->VAO.init();
+    attach_buffers();
+}
+
+void GeometryArena::attach_buffers() {
+    this->VAO.bind();
+
+    GLState::bind_buffer(GL_ARRAY_BUFFER, this->vertex_buffer);
+    for (const VertexArray::Attribute& attribute : this->attributes) {
+        this->VAO.add_attribute(attribute);
+    }
+
+    GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, this->index_buffer);
+}
+
+void GeometryArena::grow_buffer(GLuint* buffer, size_t old_size, size_t new_size) {
+    GLuint grown;
+    glGenBuffers(1, &grown);
+
+    GLState::bind_buffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, new_size, nullptr, GL_STATIC_DRAW);
+
+    GLState::bind_buffer(GL_COPY_READ_BUFFER, *buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_size);
+
+    GLState::on_delete_buffer(*buffer);
+    glDeleteBuffers(1, buffer);
+    *buffer = grown;
+}
+
+nstd::U32 GeometryArena::alloc(const void* vertices, nstd::U32 vertex_count, const GLuint* indices, nstd::U32 index_count) {
+    if (!this->vertex_size) {
+        LOGE("geometry arena used before init");
+        return invalid_handle;
+    }
+
+    nstd::U32 base_vertex;
+    nstd::U32 first_index;
+
+    // a fragmented arena is compacted before it is grown
+    for (int attempt = 0; !this->vertex_ranges.alloc(vertex_count, &base_vertex); attempt++) {
+        RangeList* ranges = &this->vertex_ranges;
+
+        if (attempt == 0 && ranges->capacity - ranges->used >= vertex_count) {
+            compact();
+            continue;
+        }
+
+        nstd::U32 capacity = nstd::max(ranges->capacity * 2, ranges->used + vertex_count);
+        grow_buffer(&this->vertex_buffer, (size_t) ranges->capacity * this->vertex_size, (size_t) capacity * this->vertex_size);
+        ranges->grow(capacity);
+        attach_buffers();
+    }
+
+    for (int attempt = 0; !this->index_ranges.alloc(index_count, &first_index); attempt++) {
+        RangeList* ranges = &this->index_ranges;
+
+        if (attempt == 0 && ranges->capacity - ranges->used >= index_count) {
+            this->vertex_ranges.free(base_vertex, vertex_count);
+            compact();
+
+            // compaction moved the vertex tail, take the vertex range again
+            this->vertex_ranges.alloc(vertex_count, &base_vertex);
+            continue;
+        }
+
+        nstd::U32 capacity = nstd::max(ranges->capacity * 2, ranges->used + index_count);
+        grow_buffer(&this->index_buffer, (size_t) ranges->capacity * sizeof(GLuint), (size_t) capacity * sizeof(GLuint));
+        ranges->grow(capacity);
+        attach_buffers();
+    }
+
+    GLState::bind_buffer(GL_ARRAY_BUFFER, this->vertex_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, (size_t) base_vertex * this->vertex_size, (size_t) vertex_count * this->vertex_size, vertices);
+
+    GLState::bind_buffer(GL_COPY_WRITE_BUFFER, this->index_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t) first_index * sizeof(GLuint), (size_t) index_count * sizeof(GLuint), indices);
+
+    nstd::U32 handle;
+    if (!this->free_handles.empty()) {
+        handle = this->free_handles.back();
+        this->free_handles.pop_back();
+    } else {
+        handle = (nstd::U32) this->allocations.size();
+        this->allocations.push_back({});
+    }
+
+    this->allocations[handle] = { base_vertex, vertex_count, first_index, index_count, true };
+    return handle;
+}
+
+void GeometryArena::free(nstd::U32 handle) {
+    if (handle >= this->allocations.size() || !this->allocations[handle].live) {
+        LOGE("geometry arena free of invalid handle %u", handle);
+        return;
+    }
+
+    Allocation* allocation = &this->allocations[handle];
+    this->vertex_ranges.free(allocation->base_vertex, allocation->vertex_count);
+    this->index_ranges.free(allocation->first_index, allocation->index_count);
+
+    allocation->live = false;
+    this->free_handles.push_back(handle);
+}
+
+void GeometryArena::compact() {
+    GLuint vertices;
+    GLuint indices;
+    glGenBuffers(1, &vertices);
+    glGenBuffers(1, &indices);
+
+    GLState::bind_buffer(GL_COPY_WRITE_BUFFER, vertices);
+    glBufferData(GL_COPY_WRITE_BUFFER, (size_t) this->vertex_ranges.capacity * this->vertex_size, nullptr, GL_STATIC_DRAW);
+    GLState::bind_buffer(GL_COPY_WRITE_BUFFER, indices);
+    glBufferData(GL_COPY_WRITE_BUFFER, (size_t) this->index_ranges.capacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+
+    // indices are relative to base_vertex so only the offsets change
+    nstd::U32 vertex_end = 0;
+    nstd::U32 index_end = 0;
+
+    for (Allocation& allocation : this->allocations) {
+        if (!allocation.live) {
+            continue;
+        }
+
+        GLState::bind_buffer(GL_COPY_READ_BUFFER, this->vertex_buffer);
+        GLState::bind_buffer(GL_COPY_WRITE_BUFFER, vertices);
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 
+            (size_t) allocation.base_vertex * this->vertex_size, 
+            (size_t) vertex_end * this->vertex_size, 
+            (size_t) allocation.vertex_count * this->vertex_size
+        );
+
+        GLState::bind_buffer(GL_COPY_READ_BUFFER, this->index_buffer);
+        GLState::bind_buffer(GL_COPY_WRITE_BUFFER, indices);
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 
+            (size_t) allocation.first_index * sizeof(GLuint), 
+            (size_t) index_end * sizeof(GLuint), 
+            (size_t) allocation.index_count * sizeof(GLuint)
+        );
+
+        allocation.base_vertex = vertex_end;
+        allocation.first_index = index_end;
+        vertex_end += allocation.vertex_count;
+        index_end += allocation.index_count;
+    }
+
+    GLState::on_delete_buffer(this->vertex_buffer);
+    GLState::on_delete_buffer(this->index_buffer);
+    glDeleteBuffers(1, &this->vertex_buffer);
+    glDeleteBuffers(1, &this->index_buffer);
+
+    this->vertex_buffer = vertices;
+    this->index_buffer = indices;
+    this->vertex_ranges.pack(vertex_end);
+    this->index_ranges.pack(index_end);
+
+    attach_buffers();
+}
+
+const GeometryArena::Allocation* GeometryArena::get(nstd::U32 handle) const {
+    if (handle >= this->allocations.size() || !this->allocations[handle].live) {
+        return nullptr;
+    }
+
+    return &this->allocations[handle];
+}
+
+void GeometryArena::bind() const {
+    this->VAO.bind();
+}
+
+void GeometryArena::draw(nstd::U32 handle, GLenum mode) const {
+    const Allocation* allocation = get(handle);
+    if (!allocation) {
+        LOGE("geometry arena draw of invalid handle %u", handle);
+        return;
+    }
+
+    draw(handle, 0, allocation->index_count, mode);
+}
+
+void GeometryArena::draw(nstd::U32 handle, nstd::U32 first_index, nstd::U32 index_count, GLenum mode) const {
+    const Allocation* allocation = get(handle);
+    if (!allocation) {
+        LOGE("geometry arena draw of invalid handle %u", handle);
+        return;
+    }
+
+    if (first_index + index_count > allocation->index_count) {
+        LOGE("geometry arena draw range out of bounds");
+        return;
+    }
+
+    bind();
+
+    glDrawElementsBaseVertex(
+        mode, 
+        index_count, 
+        GL_UNSIGNED_INT, 
+        (void*) ((size_t) (allocation->first_index + first_index) * sizeof(GLuint)), 
+        allocation->base_vertex
+    );
+}
@@ -1,46 +1,170 @@
 #include "main.hpp"
 
-// creates a mesh
-Mesh::Mesh(
-    const std::vector<Vertex>& vertices, 
-    const std::vector<GLuint>& indices
+void Mesh::upload(
+    const void* vertex_data, 
+    size_t vertex_count, 
+    GLsizei vertex_size, 
+    const VertexArray::Attribute* attributes, 
+    int num_attributes,
+    const void* index_data,
+    size_t index_count,
+    GLenum index_type,
+    GeometryArena* arena
 ) {
-    this->vertices = vertices;
-    this->indices = indices;
+    this->arena_handle = GeometryArena::invalid_handle;
+    this->vertex_size = vertex_size;
+    this->vertex_count = vertex_count;
+    this->index_count = index_count;
+    this->index_type = index_type;
+
+    // the arena's index buffer is 32 bit, 16 bit meshes keep their own buffers
+    this->arena = index_type == GL_UNSIGNED_INT ? arena : nullptr;
+
+    if (this->arena) {
+        if (arena->vertex_size != vertex_size) {
+            LOGE("mesh vertex format does not match the arena");
+            return;
+        }
+
+        this->arena_handle = arena->alloc(vertex_data, vertex_count, (const GLuint*) index_data, index_count);
+        return;
+    }
 
     this->VAO.init();
-    this->VBO.init(vertices);
-    this->EBO.init(indices);
+    this->VBO.init(vertex_data, vertex_count * vertex_size);
+    this->EBO.init(index_data, index_count * (index_type == GL_UNSIGNED_SHORT ? sizeof(nstd::U16) : sizeof(GLuint)));
 
-    this->VAO.add_attribute(VertexArray::vertex_position_attribute);
-    this->VAO.add_attribute(VertexArray::vertex_normal_attribute);
-    this->VAO.add_attribute(VertexArray::vertex_color_attribute);
-    this->VAO.add_attribute(VertexArray::vertex_texUV_attribute);
+    this->VAO.add_attributes(attributes, num_attributes);
 
     this->VAO.unbind();
     this->VBO.unbind();
     this->EBO.unbind();
 }
 
+Mesh::Mesh(const MeshFile* file, nstd::U32 submesh_index, GeometryArena* arena) {
+    this->vertices = nullptr;
+    this->indices = nullptr;
+    this->arena = nullptr;
+    this->arena_handle = GeometryArena::invalid_handle;
+    this->vertex_size = 0;
+    this->index_type = GL_UNSIGNED_INT;
+    this->vertex_count = 0;
+    this->index_count = 0;
+    this->bounds_min = glm::vec3(0);
+    this->bounds_max = glm::vec3(0);
+    this->cache_stats = { 0.0f, 0.0f };
+
+    const MeshFile::Submesh* submesh = file->get_submesh(submesh_index);
+    if (!submesh) {
+        LOGE("mesh file has no submesh %u", submesh_index);
+        this->lods.push_back({ 0, 0, 0.0f });
+        return;
+    }
+
+    // the submesh's levels are contiguous, rebase them onto its first index
+    const MeshSimplifier::Level* levels = &file->lods[submesh->first_lod];
+    const MeshSimplifier::Level* last = &levels[submesh->lod_count - 1];
+    nstd::U32 first_index = levels[0].first_index;
+    nstd::U32 index_count = last->first_index + last->index_count - first_index;
+
+    for (nstd::U32 i = 0; i < submesh->lod_count; i++) {
+        this->lods.push_back({ levels[i].first_index - first_index, levels[i].index_count, levels[i].error });
+    }
+
+    this->bounds_min = glm::vec3(submesh->bounds_min[0], submesh->bounds_min[1], submesh->bounds_min[2]);
+    this->bounds_max = glm::vec3(submesh->bounds_max[0], submesh->bounds_max[1], submesh->bounds_max[2]);
+    this->cache_stats = submesh->cache_stats;
+
+    if (submesh->meshlet_count > 0) {
+        this->meshlets.init(&file->meshlets[submesh->first_meshlet], submesh->meshlet_count, first_index);
+    }
+
+    int num_attributes;
+    const VertexArray::Attribute* attributes = MeshFile::get_layout((MeshFile::VertexFormat) file->header->vertex_format, &num_attributes);
+
+    upload(
+        file->vertices + (size_t) submesh->base_vertex * file->header->vertex_size, 
+        submesh->vertex_count, 
+        file->header->vertex_size, 
+        attributes, num_attributes, 
+        file->indices + first_index, 
+        index_count, 
+        GL_UNSIGNED_INT, 
+        arena
+    );
+}
+
 // destroys a mesh
 Mesh::~Mesh() {
-    this->vertices.clear();
-    this->indices.clear();
+    if (this->arena && this->arena_handle != GeometryArena::invalid_handle) {
+        this->arena->free(this->arena_handle);
+    }
+
+    release_cpu_data();
+}
+
+void Mesh::release_cpu_data() {
+    this->vertex_owner.reset();
+    this->index_owner.reset();
+    this->vertices = nullptr;
+    this->indices = nullptr;
+}
+
+void Mesh::log_stats(const char* name) const {
+    LOGI(
+        "%s: %zu vertices, %zu triangles, %s indices, acmr %.3f, atvr %.3f", 
+        name, this->vertex_count, this->index_count / 3, 
+        this->index_type == GL_UNSIGNED_SHORT ? "16 bit" : "32 bit", 
+        this->cache_stats.acmr, this->cache_stats.atvr
+    );
+}
+
+int Mesh::select_lod(const Camera* camera, const SceneObject* binding, float pixel_error) const {
+    if (this->lods.size() <= 1) {
+        return 0;
+    }
+
+    glm::vec3 extent = this->bounds_max - this->bounds_min;
+    glm::vec3 center = (this->bounds_min + this->bounds_max) * 0.5f;
+    glm::vec4 world_center = binding->get_model_matrix() * glm::vec4(center, 1.0f);
+
+    float scale = std::max(binding->scale.x, std::max(binding->scale.y, binding->scale.z));
+    float radius = glm::length(extent * binding->scale) * 0.5f;
+
+    // level errors are relative to the largest side of the bounds
+    float size = std::max(extent.x, std::max(extent.y, extent.z)) * scale;
+    float pixels = camera->projected_size(glm::vec3(world_center.x, world_center.y, world_center.z), radius);
+    float pixels_per_unit = radius > 0.0f ? pixels / (radius * 2.0f) : 0.0f;
+
+    for (int lod = (int) this->lods.size() - 1; lod > 0; lod--) {
+        if (this->lods[lod].error * size * pixels_per_unit <= pixel_error) {
+            return lod;
+        }
+    }
+
+    return 0;
 }
 
 // draws mesh with shader
-void Mesh::draw(const ShaderProgram* shader, const SceneObject* binding) {
+void Mesh::draw(const ShaderProgram* shader, const SceneObject* binding, int lod) {
+    static const nstd::U32 model_uniform = nstd::StringTable::intern("model");
+
     shader->set_uniform_matrix_4fv(
-        "model", 
+        model_uniform, 
         (GLfloat*) glm::value_ptr(binding->get_model_matrix())
     );
 
-    this->VAO.bind();
+    const MeshSimplifier::Level& level = this->lods[nstd::min((size_t) lod, this->lods.size() - 1)];
 
-    // ??
-    glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
+    // meshes in the same arena share a vertex array, so switching between them binds nothing
+    if (this->arena) {
+        this->arena->draw(this->arena_handle, level.first_index, level.index_count);
+        return;
+    }
 
-    this->VAO.unbind();
+    // bindings are left in place, the state tracker drops the rebind on the next draw of this mesh
+    this->VAO.bind();
 
-    Texture::unbind();
+    size_t index_size = this->index_type == GL_UNSIGNED_SHORT ? sizeof(nstd::U16) : sizeof(GLuint);
+    glDrawElements(GL_TRIANGLES, level.index_count, this->index_type, (void*) (level.first_index * index_size));
 }
\ No newline at end of file
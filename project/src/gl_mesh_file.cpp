@@ -0,0 +1,271 @@
+#include "main.hpp"
+
+static nstd::U64 align_offset(nstd::U64 offset) {
+    return (offset + MeshFile::alignment - 1) / MeshFile::alignment * MeshFile::alignment;
+}
+
+MeshFile::MeshFile() {
+    this->header = nullptr;
+    this->submeshes = nullptr;
+    this->lods = nullptr;
+    this->meshlets = nullptr;
+    this->vertices = nullptr;
+    this->indices = nullptr;
+}
+
+const VertexArray::Attribute* MeshFile::get_layout(VertexFormat format, int* count) {
+    switch (format) {
+        case MESH_FORMAT_VERTEX:
+            *count = VertexLayout<Vertex>::count;
+            return VertexLayout<Vertex>::attributes;
+        case MESH_FORMAT_COMPACT:
+            *count = VertexLayout<VertexCompact>::count;
+            return VertexLayout<VertexCompact>::attributes;
+        case MESH_FORMAT_POSITION:
+            *count = VertexLayout<VertexPosition>::count;
+            return VertexLayout<VertexPosition>::attributes;
+        default:
+            *count = 0;
+            return nullptr;
+    }
+}
+
+static nstd::U32 format_size(MeshFile::VertexFormat format) {
+    switch (format) {
+        case MeshFile::MESH_FORMAT_VERTEX: return sizeof(Vertex);
+        case MeshFile::MESH_FORMAT_COMPACT: return sizeof(VertexCompact);
+        case MeshFile::MESH_FORMAT_POSITION: return sizeof(VertexPosition);
+        default: return 0;
+    }
+}
+
+bool MeshFile::open(const char* path) {
+    close();
+
+    if (!this->file.open(path)) {
+        return false;
+    }
+
+    const nstd::U8* data = (const nstd::U8*) this->file.data;
+    size_t size = this->file.size;
+    const Header* header = (const Header*) data;
+
+    if (size < sizeof(Header) || header->magic != magic) {
+        LOGE("%s is not a mesh file", path);
+        close();
+        return false;
+    }
+
+    if (header->version != version) {
+        LOGE("mesh file %s has version %u, expected %u", path, header->version, version);
+        close();
+        return false;
+    }
+
+    if (header->vertex_format >= MESH_FORMAT_MAX || header->vertex_size != format_size((VertexFormat) header->vertex_format)) {
+        LOGE("mesh file %s has an unknown vertex format", path);
+        close();
+        return false;
+    }
+
+    // every section has to lie inside the mapping, the tables are checked entry by entry below
+    bool sections_valid = header->file_size == size
+        && header->submesh_offset + (nstd::U64) header->submesh_count * sizeof(Submesh) <= size
+        && header->lod_offset + (nstd::U64) header->lod_count * sizeof(MeshSimplifier::Level) <= size
+        && header->meshlet_offset + (nstd::U64) header->meshlet_count * sizeof(MeshletSet::Meshlet) <= size
+        && header->vertex_offset + (nstd::U64) header->vertex_count * header->vertex_size <= size
+        && header->index_offset + (nstd::U64) header->index_count * sizeof(GLuint) <= size
+        && header->submesh_offset % alignment == 0
+        && header->lod_offset % alignment == 0
+        && header->meshlet_offset % alignment == 0
+        && header->vertex_offset % alignment == 0
+        && header->index_offset % alignment == 0;
+
+    if (!sections_valid) {
+        LOGE("mesh file %s is truncated or corrupt", path);
+        close();
+        return false;
+    }
+
+    this->header = header;
+    this->submeshes = (const Submesh*) (data + header->submesh_offset);
+    this->lods = (const MeshSimplifier::Level*) (data + header->lod_offset);
+    this->meshlets = (const MeshletSet::Meshlet*) (data + header->meshlet_offset);
+    this->vertices = data + header->vertex_offset;
+    this->indices = (const GLuint*) (data + header->index_offset);
+
+    for (nstd::U32 i = 0; i < header->submesh_count; i++) {
+        const Submesh* submesh = &this->submeshes[i];
+        bool valid = (nstd::U64) submesh->base_vertex + submesh->vertex_count <= header->vertex_count
+            && (nstd::U64) submesh->first_lod + submesh->lod_count <= header->lod_count
+            && (nstd::U64) submesh->first_meshlet + submesh->meshlet_count <= header->meshlet_count
+            && submesh->lod_count > 0;
+
+        for (nstd::U32 l = 0; valid && l < submesh->lod_count; l++) {
+            const MeshSimplifier::Level* lod = &this->lods[submesh->first_lod + l];
+            valid = (nstd::U64) lod->first_index + lod->index_count <= header->index_count;
+
+            // indices are relative to the submesh, one past its vertices would be fetched out of bounds
+            for (nstd::U32 n = 0; valid && n < lod->index_count; n++) {
+                valid = this->indices[lod->first_index + n] < submesh->vertex_count;
+            }
+        }
+
+        // meshlets have to stay inside lod 0, they are drawn in its place
+        for (nstd::U32 m = 0; valid && m < submesh->meshlet_count; m++) {
+            const MeshletSet::Meshlet* meshlet = &this->meshlets[submesh->first_meshlet + m];
+            const MeshSimplifier::Level* lod = &this->lods[submesh->first_lod];
+            valid = meshlet->first_index >= lod->first_index
+                && (nstd::U64) meshlet->first_index + meshlet->triangle_count * 3ull <= (nstd::U64) lod->first_index + lod->index_count;
+        }
+
+        if (!valid) {
+            LOGE("mesh file %s has a bad submesh %u", path, i);
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool MeshFile::matches_source(const char* source_path) const {
+    if (!this->header) {
+        return false;
+    }
+
+    FileStamp source;
+    if (!FileStamp::get(source_path, &source)) {
+        return true;
+    }
+
+    return this->header->source_size == source.size && this->header->source_mtime == source.mtime;
+}
+
+void MeshFile::close() {
+    this->file.close();
+    this->header = nullptr;
+    this->submeshes = nullptr;
+    this->lods = nullptr;
+    this->meshlets = nullptr;
+    this->vertices = nullptr;
+    this->indices = nullptr;
+}
+
+const MeshFile::Submesh* MeshFile::get_submesh(nstd::U32 index) const {
+    if (!this->header || index >= this->header->submesh_count) {
+        return nullptr;
+    }
+
+    return &this->submeshes[index];
+}
+
+const MeshFile::Submesh* MeshFile::find_submesh(const char* name) const {
+    for (nstd::U32 i = 0; this->header && i < this->header->submesh_count; i++) {
+        if (strncmp(this->submeshes[i].name, name, sizeof(Submesh::name)) == 0) {
+            return &this->submeshes[i];
+        }
+    }
+
+    return nullptr;
+}
+
+// writes zeros up to the next section boundary
+static bool write_padding(FILE* file, nstd::U64* offset) {
+    static const nstd::U8 zeros[MeshFile::alignment] = {};
+
+    nstd::U64 aligned = align_offset(*offset);
+    size_t padding = (size_t) (aligned - *offset);
+    *offset = aligned;
+
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+static bool write_section(FILE* file, nstd::U64* offset, const void* data, size_t size) {
+    *offset += size;
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+bool MeshFile::write(
+    const char* path,
+    VertexFormat format,
+    nstd::U32 vertex_size,
+    const void* vertices,
+    nstd::U32 vertex_count,
+    const GLuint* indices,
+    nstd::U32 index_count,
+    const Submesh* submeshes,
+    nstd::U32 submesh_count,
+    const MeshSimplifier::Level* lods,
+    nstd::U32 lod_count,
+    const MeshletSet::Meshlet* meshlets,
+    nstd::U32 meshlet_count,
+    const char* source_path
+) {
+    if (vertex_size != format_size(format)) {
+        LOGE("mesh file vertex size does not match its format");
+        return false;
+    }
+
+    Header header = {};
+    header.magic = magic;
+    header.version = version;
+    header.vertex_format = format;
+    header.vertex_size = vertex_size;
+    header.vertex_count = vertex_count;
+    header.index_count = index_count;
+    header.submesh_count = submesh_count;
+    header.lod_count = lod_count;
+    header.meshlet_count = meshlet_count;
+
+    FileStamp source;
+    if (source_path && FileStamp::get(source_path, &source)) {
+        header.source_size = source.size;
+        header.source_mtime = source.mtime;
+    }
+
+    header.submesh_offset = align_offset(sizeof(Header));
+    header.lod_offset = align_offset(header.submesh_offset + (nstd::U64) submesh_count * sizeof(Submesh));
+    header.meshlet_offset = align_offset(header.lod_offset + (nstd::U64) lod_count * sizeof(MeshSimplifier::Level));
+    header.vertex_offset = align_offset(header.meshlet_offset + (nstd::U64) meshlet_count * sizeof(MeshletSet::Meshlet));
+    header.index_offset = align_offset(header.vertex_offset + (nstd::U64) vertex_count * vertex_size);
+    header.file_size = align_offset(header.index_offset + (nstd::U64) index_count * sizeof(GLuint));
+
+    // file bounds enclose every submesh
+    for (nstd::U32 i = 0; i < submesh_count; i++) {
+        for (int k = 0; k < 3; k++) {
+            header.bounds_min[k] = i == 0 ? submeshes[i].bounds_min[k] : std::min(header.bounds_min[k], submeshes[i].bounds_min[k]);
+            header.bounds_max[k] = i == 0 ? submeshes[i].bounds_max[k] : std::max(header.bounds_max[k], submeshes[i].bounds_max[k]);
+        }
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        LOGE("failed to write mesh file %s", path);
+        return false;
+    }
+
+    nstd::U64 offset = 0;
+    bool ok = write_section(file, &offset, &header, sizeof(Header))
+        && write_padding(file, &offset)
+        && write_section(file, &offset, submeshes, (size_t) submesh_count * sizeof(Submesh))
+        && write_padding(file, &offset)
+        && write_section(file, &offset, lods, (size_t) lod_count * sizeof(MeshSimplifier::Level))
+        && write_padding(file, &offset)
+        && write_section(file, &offset, meshlets, (size_t) meshlet_count * sizeof(MeshletSet::Meshlet))
+        && write_padding(file, &offset)
+        && write_section(file, &offset, vertices, (size_t) vertex_count * vertex_size)
+        && write_padding(file, &offset)
+        && write_section(file, &offset, indices, (size_t) index_count * sizeof(GLuint))
+        && write_padding(file, &offset);
+
+    fclose(file);
+
+    if (!ok || offset != header.file_size) {
+        LOGE("failed to write mesh file %s", path);
+        remove(path);
+        return false;
+    }
+
+    return true;
+}
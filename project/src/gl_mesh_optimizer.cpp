@@ -0,0 +1,372 @@
+#include "main.hpp"
+
+/*
+    vertex cache
+*/
+
+static constexpr int max_valence = 32;
+
+// score tables of Forsyth's algorithm, the three most recent vertices share a fixed score
+// so the next triangle does not prefer one edge of the last one
+struct ScoreTables {
+    float cache[MeshOptimizer::cache_size + 1];
+    float valence[max_valence + 1];
+
+    ScoreTables() {
+        for (int i = 0; i < MeshOptimizer::cache_size; i++) {
+            if (i < 3) {
+                this->cache[i] = 0.75f;
+            } else {
+                float scaled = 1.0f - (float) (i - 3) / (float) (MeshOptimizer::cache_size - 3);
+                this->cache[i] = powf(scaled, 1.5f);
+            }
+        }
+
+        this->cache[MeshOptimizer::cache_size] = 0.0f;
+
+        this->valence[0] = 0.0f;
+        for (int i = 1; i <= max_valence; i++) {
+            this->valence[i] = 2.0f / sqrtf((float) i);
+        }
+    }
+};
+
+// built once on first use, function local statics are initialized thread safely
+static const ScoreTables& score_tables() {
+    static const ScoreTables tables;
+    return tables;
+}
+
+static float vertex_score(const ScoreTables& tables, int cache_position, nstd::U32 remaining) {
+    if (remaining == 0) {
+        return -1.0f;
+    }
+
+    int position = cache_position < 0 ? MeshOptimizer::cache_size : cache_position;
+    return tables.cache[position] + tables.valence[nstd::min(remaining, max_valence)];
+}
+
+void MeshOptimizer::optimize_vertex_cache(GLuint* indices, size_t index_count, size_t vertex_count) {
+    const ScoreTables& tables = score_tables();
+
+    size_t face_count = index_count / 3;
+    if (face_count == 0) {
+        return;
+    }
+
+    // triangles of each vertex in one array, offsets per vertex
+    std::vector<nstd::U32> remaining(vertex_count, 0);
+    for (size_t i = 0; i < face_count * 3; i++) {
+        remaining[indices[i]]++;
+    }
+
+    std::vector<nstd::U32> offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+
+    std::vector<nstd::U32> adjacency(face_count * 3);
+    std::vector<nstd::U32> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t f = 0; f < face_count; f++) {
+        for (int k = 0; k < 3; k++) {
+            adjacency[fill[indices[f * 3 + k]]++] = (nstd::U32) f;
+        }
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> scores(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) {
+        scores[v] = vertex_score(tables, -1, remaining[v]);
+    }
+
+    std::vector<float> face_scores(face_count);
+    std::vector<bool> emitted(face_count, false);
+    for (size_t f = 0; f < face_count; f++) {
+        face_scores[f] = scores[indices[f * 3]] + scores[indices[f * 3 + 1]] + scores[indices[f * 3 + 2]];
+    }
+
+    std::vector<GLuint> output(face_count * 3);
+
+    // the cache holds up to cache_size vertices plus the three pushed by the last triangle
+    GLuint cache[cache_size + 3];
+    GLuint next_cache[cache_size + 3];
+    int cache_count = 0;
+
+    size_t scan = 0;
+    nstd::S64 best = -1;
+
+    for (size_t out = 0; out < face_count; out++) {
+        // nothing in the cache touches a live triangle, take the next one in input order
+        if (best < 0) {
+            while (emitted[scan]) {
+                scan++;
+            }
+
+            best = (nstd::S64) scan;
+        }
+
+        GLuint* face = &indices[best * 3];
+        memcpy(&output[out * 3], face, sizeof(GLuint) * 3);
+        emitted[best] = true;
+
+        // push the triangle's vertices to the front of the cache
+        int next_count = 0;
+        for (int k = 0; k < 3; k++) {
+            next_cache[next_count++] = face[k];
+        }
+
+        for (int i = 0; i < cache_count; i++) {
+            GLuint v = cache[i];
+
+            if (v != face[0] && v != face[1] && v != face[2]) {
+                next_cache[next_count++] = v;
+            }
+        }
+
+        // take the triangle out of its vertices' adjacency
+        for (int k = 0; k < 3; k++) {
+            GLuint v = face[k];
+            nstd::U32* begin = &adjacency[offsets[v]];
+            nstd::U32* end = begin + remaining[v];
+            nstd::U32* found = std::find(begin, end, (nstd::U32) best);
+
+            *found = *(end - 1);
+            remaining[v]--;
+        }
+
+        // rescore every vertex that was or is in the cache, evicted vertices drop to the base score
+        for (int i = 0; i < next_count; i++) {
+            GLuint v = next_cache[i];
+            int position = i < cache_size ? i : -1;
+
+            cache_position[v] = position;
+            float score = vertex_score(tables, position, remaining[v]);
+            float delta = score - scores[v];
+            scores[v] = score;
+
+            for (nstd::U32 t = 0; t < remaining[v]; t++) {
+                face_scores[adjacency[offsets[v] + t]] += delta;
+            }
+        }
+
+        cache_count = nstd::min(next_count, cache_size);
+        memcpy(cache, next_cache, sizeof(GLuint) * cache_count);
+
+        // best live triangle around the cache
+        best = -1;
+        float best_score = -1.0f;
+
+        for (int i = 0; i < cache_count; i++) {
+            GLuint v = cache[i];
+
+            for (nstd::U32 t = 0; t < remaining[v]; t++) {
+                nstd::U32 f = adjacency[offsets[v] + t];
+
+                if (face_scores[f] > best_score) {
+                    best_score = face_scores[f];
+                    best = f;
+                }
+            }
+        }
+    }
+
+    memcpy(indices, output.data(), sizeof(GLuint) * face_count * 3);
+}
+
+/*
+    overdraw
+*/
+
+// a run of triangles drawn together, sorted by how much it faces outwards
+typedef struct {
+    size_t first;
+    size_t count;
+    float sort_key;
+} Cluster;
+
+void MeshOptimizer::optimize_overdraw(
+    GLuint* indices, 
+    size_t index_count, 
+    const float* positions, 
+    size_t position_stride, 
+    size_t vertex_count, 
+    float threshold
+) {
+    size_t face_count = index_count / 3;
+    if (face_count < 2) {
+        return;
+    }
+
+    auto position = [&](GLuint v) {
+        const float* p = (const float*) ((const nstd::U8*) positions + v * position_stride);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    // cache misses per triangle with the cache the order was tuned for
+    std::vector<nstd::U8> face_misses(face_count);
+    std::vector<size_t> loaded_at(vertex_count, 0);
+    size_t misses = 0;
+
+    for (size_t f = 0; f < face_count; f++) {
+        nstd::U8 face_miss = 0;
+
+        for (int k = 0; k < 3; k++) {
+            GLuint v = indices[f * 3 + k];
+
+            if (loaded_at[v] == 0 || misses - loaded_at[v] >= (size_t) cache_size) {
+                misses++;
+                loaded_at[v] = misses;
+                face_miss++;
+            }
+        }
+
+        face_misses[f] = face_miss;
+    }
+
+    // hard boundaries where the cache restarts cold, reordering there costs nothing
+    std::vector<size_t> hard;
+    for (size_t f = 0; f < face_count; f++) {
+        if (f == 0 || face_misses[f] == 3) {
+            hard.push_back(f);
+        }
+    }
+    hard.push_back(face_count);
+
+    // soft boundaries inside hard clusters once the running miss ratio is within threshold of the cluster's
+    std::vector<Cluster> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); h++) {
+        size_t start = hard[h];
+        size_t end = hard[h + 1];
+
+        size_t cluster_misses = 0;
+        for (size_t f = start; f < end; f++) {
+            cluster_misses += face_misses[f];
+        }
+
+        float cluster_acmr = (float) cluster_misses / (float) (end - start);
+        size_t first = start;
+        size_t running = 0;
+
+        for (size_t f = start; f < end; f++) {
+            running += face_misses[f];
+            size_t count = f + 1 - first;
+
+            bool last = f + 1 == end;
+            bool soft = count >= 8 && face_misses[f + 1 < end ? f + 1 : f] > 0 && 
+                (float) running / (float) count <= cluster_acmr * threshold;
+
+            if (last || soft) {
+                clusters.push_back({ first, count, 0.0f });
+                first = f + 1;
+                running = 0;
+            }
+        }
+    }
+
+    // mesh centroid by area
+    glm::vec3 mesh_centroid(0);
+    float mesh_area = 0.0f;
+
+    for (size_t f = 0; f < face_count; f++) {
+        glm::vec3 a = position(indices[f * 3]);
+        glm::vec3 b = position(indices[f * 3 + 1]);
+        glm::vec3 c = position(indices[f * 3 + 2]);
+
+        float area = glm::length(glm::cross(b - a, c - a));
+        mesh_centroid += (a + b + c) * (area / 3.0f);
+        mesh_area += area;
+    }
+
+    if (mesh_area > 0.0f) {
+        mesh_centroid /= mesh_area;
+    }
+
+    // clusters facing away from the mesh centre are likely in front, draw them first
+    for (Cluster& cluster : clusters) {
+        glm::vec3 centroid(0);
+        glm::vec3 normal(0);
+        float area = 0.0f;
+
+        for (size_t f = cluster.first; f < cluster.first + cluster.count; f++) {
+            glm::vec3 a = position(indices[f * 3]);
+            glm::vec3 b = position(indices[f * 3 + 1]);
+            glm::vec3 c = position(indices[f * 3 + 2]);
+
+            glm::vec3 n = glm::cross(b - a, c - a);
+            float face_area = glm::length(n);
+
+            centroid += (a + b + c) * (face_area / 3.0f);
+            normal += n;
+            area += face_area;
+        }
+
+        if (area > 0.0f) {
+            centroid /= area;
+        }
+
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normal /= length;
+        }
+
+        cluster.sort_key = glm::dot(centroid - mesh_centroid, normal);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sort_key > b.sort_key;
+    });
+
+    std::vector<GLuint> output(face_count * 3);
+    size_t out = 0;
+
+    for (const Cluster& cluster : clusters) {
+        memcpy(&output[out], &indices[cluster.first * 3], cluster.count * 3 * sizeof(GLuint));
+        out += cluster.count * 3;
+    }
+
+    memcpy(indices, output.data(), face_count * 3 * sizeof(GLuint));
+}
+
+/*
+    vertex fetch
+*/
+
+size_t MeshOptimizer::optimize_vertex_fetch_remap(GLuint* remap, const GLuint* indices, size_t index_count, size_t vertex_count) {
+    for (size_t v = 0; v < vertex_count; v++) {
+        remap[v] = ~0u;
+    }
+
+    GLuint next = 0;
+    for (size_t i = 0; i < index_count; i++) {
+        if (remap[indices[i]] == ~0u) {
+            remap[indices[i]] = next++;
+        }
+    }
+
+    return next;
+}
+
+bool MeshOptimizer::narrow_indices(const GLuint* indices, size_t index_count, std::vector<nstd::U16>* out) {
+    for (size_t i = 0; i < index_count; i++) {
+        if (indices[i] > 0xFFFF) {
+            return false;
+        }
+    }
+
+    out->resize(index_count);
+    for (size_t i = 0; i < index_count; i++) {
+        (*out)[i] = (nstd::U16) indices[i];
+    }
+
+    return true;
+}
+
+void MeshOptimizer::log_report(const char* name, const Report* report) {
+    LOGI(
+        "%s: acmr %.3f -> %.3f, atvr %.3f -> %.3f, %s indices", 
+        name, 
+        report->before.acmr, report->after.acmr, 
+        report->before.atvr, report->after.atvr, 
+        report->narrow ? "16 bit" : "32 bit"
+    );
+}
@@ -0,0 +1,529 @@
+#include "main.hpp"
+
+/*
+    quadrics
+*/
+
+// weighted sum of squared distances to a set of planes, error(p) = (p^T A p + 2 b.p + c) / w
+typedef struct {
+    double a00, a11, a22, a01, a02, a12;
+    double b0, b1, b2;
+    double c;
+    double w;
+} Quadric;
+
+static void quadric_add_plane(Quadric* q, const double* n, double d, double weight) {
+    q->a00 += weight * n[0] * n[0];
+    q->a11 += weight * n[1] * n[1];
+    q->a22 += weight * n[2] * n[2];
+    q->a01 += weight * n[0] * n[1];
+    q->a02 += weight * n[0] * n[2];
+    q->a12 += weight * n[1] * n[2];
+    q->b0 += weight * n[0] * d;
+    q->b1 += weight * n[1] * d;
+    q->b2 += weight * n[2] * d;
+    q->c += weight * d * d;
+    q->w += weight;
+}
+
+static void quadric_add(Quadric* q, const Quadric* other) {
+    q->a00 += other->a00;
+    q->a11 += other->a11;
+    q->a22 += other->a22;
+    q->a01 += other->a01;
+    q->a02 += other->a02;
+    q->a12 += other->a12;
+    q->b0 += other->b0;
+    q->b1 += other->b1;
+    q->b2 += other->b2;
+    q->c += other->c;
+    q->w += other->w;
+}
+
+static double quadric_error(const Quadric* q, const double* p) {
+    double ax = q->a00 * p[0] + q->a01 * p[1] + q->a02 * p[2];
+    double ay = q->a01 * p[0] + q->a11 * p[1] + q->a12 * p[2];
+    double az = q->a02 * p[0] + q->a12 * p[1] + q->a22 * p[2];
+
+    double error = p[0] * ax + p[1] * ay + p[2] * az + 2.0 * (q->b0 * p[0] + q->b1 * p[1] + q->b2 * p[2]) + q->c;
+
+    // rounding can take a zero error slightly negative
+    if (error <= 0.0 || q->w == 0.0) {
+        return 0.0;
+    }
+
+    return error / q->w;
+}
+
+/*
+    geometry helpers
+*/
+
+static void triangle_normal(const double* a, const double* b, const double* c, double* n) {
+    double e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+    n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+static double dot3(const double* a, const double* b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// positions scaled into the unit cube so errors are relative to the mesh extent
+static std::vector<double> normalize_positions(const float* positions, size_t stride, size_t vertex_count) {
+    std::vector<double> out(vertex_count * 3);
+    double lo[3] = { 0.0, 0.0, 0.0 };
+    double hi[3] = { 0.0, 0.0, 0.0 };
+
+    for (size_t v = 0; v < vertex_count; v++) {
+        const float* p = (const float*) ((const char*) positions + v * stride);
+
+        for (int k = 0; k < 3; k++) {
+            out[v * 3 + k] = p[k];
+            lo[k] = v == 0 ? p[k] : std::min(lo[k], (double) p[k]);
+            hi[k] = v == 0 ? p[k] : std::max(hi[k], (double) p[k]);
+        }
+    }
+
+    double extent = std::max(hi[0] - lo[0], std::max(hi[1] - lo[1], hi[2] - lo[2]));
+    double scale = extent > 0.0 ? 1.0 / extent : 0.0;
+
+    for (size_t v = 0; v < vertex_count; v++) {
+        for (int k = 0; k < 3; k++) {
+            out[v * 3 + k] = (out[v * 3 + k] - lo[k]) * scale;
+        }
+    }
+
+    return out;
+}
+
+// what a vertex may do in a collapse
+typedef enum {
+    VERTEX_FREE,    // inside a single chart, collapses onto any neighbour
+    VERTEX_SEAM,    // one of two copies on an attribute seam, both slide along the seam together
+    VERTEX_LOCKED,  // on an open or non manifold edge, a seam junction or seam end
+} VertexKind;
+
+typedef struct {
+    std::vector<nstd::U8> kinds;
+    std::vector<nstd::U32> groups;      // the first vertex at the same position
+    std::vector<nstd::U32> partners;    // the other copy of a seam vertex
+} VertexClasses;
+
+// welded edges are edges between positions, a seam edge is one whose two triangles
+// reference different copies of its vertices
+typedef struct {
+    nstd::U32 count;
+    nstd::U64 first;
+    bool seam;
+} WeldedEdge;
+
+static nstd::U64 edge_key(nstd::U64 a, nstd::U64 b) {
+    return a < b ? (a << 32 | b) : (b << 32 | a);
+}
+
+// classifies vertices on the position welded mesh, so copies that only differ in their
+// normals or uvs can still collapse while the seam between them stays closed
+static VertexClasses classify_vertices(const GLuint* indices, size_t index_count, const double* positions, size_t vertex_count) {
+    VertexClasses classes;
+    classes.kinds.assign(vertex_count, VERTEX_FREE);
+    classes.groups.resize(vertex_count);
+    classes.partners.resize(vertex_count);
+
+    std::vector<nstd::U32> order(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) {
+        order[v] = (nstd::U32) v;
+        classes.partners[v] = (nstd::U32) v;
+    }
+
+    auto position_less = [positions](nstd::U32 a, nstd::U32 b) {
+        return std::lexicographical_compare(positions + a * 3, positions + a * 3 + 3, positions + b * 3, positions + b * 3 + 3);
+    };
+
+    std::sort(order.begin(), order.end(), position_less);
+
+    std::vector<nstd::U32> group_size(vertex_count, 0);
+    for (size_t i = 0; i < vertex_count; i++) {
+        bool same = i > 0 && !position_less(order[i - 1], order[i]);
+        nstd::U32 group = same ? classes.groups[order[i - 1]] : order[i];
+
+        classes.groups[order[i]] = group;
+        group_size[group]++;
+
+        if (same) {
+            classes.partners[order[i]] = order[i - 1];
+            classes.partners[order[i - 1]] = order[i];
+        }
+    }
+
+    std::unordered_map<nstd::U64, WeldedEdge> edges;
+    edges.reserve(index_count);
+
+    for (size_t i = 0; i < index_count; i += 3) {
+        for (int k = 0; k < 3; k++) {
+            nstd::U32 a = indices[i + k];
+            nstd::U32 b = indices[i + (k + 1) % 3];
+            nstd::U64 original = edge_key(a, b);
+
+            WeldedEdge& edge = edges[edge_key(classes.groups[a], classes.groups[b])];
+            edge.seam = edge.seam || (edge.count > 0 && edge.first != original);
+            edge.first = edge.count == 0 ? original : edge.first;
+            edge.count++;
+        }
+    }
+
+    std::vector<bool> border(vertex_count, false);
+    std::vector<nstd::U32> seam_edges(vertex_count, 0);
+
+    for (const auto& [key, edge] : edges) {
+        nstd::U32 a = (nstd::U32) (key >> 32);
+        nstd::U32 b = (nstd::U32) (key & 0xFFFFFFFF);
+
+        if (edge.count != 2) {
+            border[a] = true;
+            border[b] = true;
+        } else if (edge.seam) {
+            seam_edges[a]++;
+            seam_edges[b]++;
+        }
+    }
+
+    // only a pair of copies on a seam running through is free to slide, more copies meet
+    // several charts and a seam that ends has nowhere to go
+    for (size_t v = 0; v < vertex_count; v++) {
+        nstd::U32 group = classes.groups[v];
+
+        if (border[group] || (group_size[group] == 1 && seam_edges[group] > 0) || group_size[group] > 2) {
+            classes.kinds[v] = VERTEX_LOCKED;
+        } else if (group_size[group] == 2) {
+            classes.kinds[v] = seam_edges[group] == 2 ? VERTEX_SEAM : VERTEX_LOCKED;
+        }
+    }
+
+    return classes;
+}
+
+/*
+    simplification
+*/
+
+typedef struct {
+    nstd::U32 from;
+    nstd::U32 to;
+    double error;
+} Collapse;
+
+// the copy of to's position that from's seam partner shares an edge with, or none when the
+// edge crosses the seam instead of running along it
+static bool seam_partner_target(
+    nstd::U32 from,
+    nstd::U32 to,
+    const GLuint* indices,
+    const nstd::U32* offsets,
+    const nstd::U32* adjacency,
+    const VertexClasses* classes,
+    nstd::U32* out
+) {
+    nstd::U32 partner = classes->partners[from];
+    nstd::U32 group = classes->groups[to];
+
+    for (nstd::U32 t = offsets[partner]; t < offsets[partner + 1]; t++) {
+        const GLuint* tri = &indices[adjacency[t] * 3];
+
+        for (int k = 0; k < 3; k++) {
+            if (tri[k] != partner && classes->groups[tri[k]] == group) {
+                *out = tri[k];
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// whether moving from onto to turns any triangle around from over or collapses it to a line
+static bool collapse_flips(
+    nstd::U32 from,
+    nstd::U32 to,
+    const GLuint* indices,
+    const nstd::U32* triangles,
+    nstd::U32 triangle_count,
+    const double* positions
+) {
+    for (nstd::U32 t = 0; t < triangle_count; t++) {
+        const GLuint* tri = &indices[triangles[t] * 3];
+
+        // triangles on the collapsed edge disappear
+        if (tri[0] == to || tri[1] == to || tri[2] == to) {
+            continue;
+        }
+
+        const double* p[3];
+        const double* q[3];
+        for (int k = 0; k < 3; k++) {
+            p[k] = positions + tri[k] * 3;
+            q[k] = positions + (tri[k] == from ? to : tri[k]) * 3;
+        }
+
+        double before[3];
+        double after[3];
+        triangle_normal(p[0], p[1], p[2], before);
+        triangle_normal(q[0], q[1], q[2], after);
+
+        // reject turns of more than about 75 degrees, and triangles flattened into a sliver
+        // which sliding along a seam or a straight border can do without turning them
+        if (dot3(before, after) < 0.25 * sqrt(dot3(before, before) * dot3(after, after)) ||
+            dot3(after, after) < 1e-6 * dot3(before, before)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t MeshSimplifier::simplify(
+    GLuint* out,
+    const GLuint* indices,
+    size_t index_count,
+    const float* positions,
+    size_t position_stride,
+    size_t vertex_count,
+    size_t target_index_count,
+    float target_error,
+    float* result_error
+) {
+    index_count -= index_count % 3;
+    std::copy(indices, indices + index_count, out);
+
+    if (result_error) {
+        *result_error = 0.0f;
+    }
+
+    if (index_count <= target_index_count || vertex_count == 0) {
+        return index_count;
+    }
+
+    std::vector<double> points = normalize_positions(positions, position_stride, vertex_count);
+    VertexClasses classes = classify_vertices(out, index_count, points.data(), vertex_count);
+    const nstd::U32* groups = classes.groups.data();
+
+    // area weighted planes of each position's triangles, copies of a position share one quadric
+    std::vector<Quadric> quadrics(vertex_count, Quadric {});
+    for (size_t i = 0; i < index_count; i += 3) {
+        const double* a = &points[out[i + 0] * 3];
+        const double* b = &points[out[i + 1] * 3];
+        const double* c = &points[out[i + 2] * 3];
+
+        double n[3];
+        triangle_normal(a, b, c, n);
+
+        double length = sqrt(dot3(n, n));
+        if (length == 0.0) {
+            continue;
+        }
+
+        n[0] /= length;
+        n[1] /= length;
+        n[2] /= length;
+
+        double d = -dot3(n, a);
+        for (int k = 0; k < 3; k++) {
+            quadric_add_plane(&quadrics[groups[out[i + k]]], n, d, length * 0.5);
+        }
+    }
+
+    double max_error = (double) target_error * (double) target_error;
+    double reached_error = 0.0;
+
+    std::vector<nstd::U32> offsets(vertex_count + 1);
+    std::vector<nstd::U32> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(vertex_count);
+    std::vector<nstd::U32> remap(vertex_count);
+
+    // each pass collapses the cheapest edges that do not share a neighbourhood, then compacts the indices
+    while (index_count > target_index_count) {
+        size_t face_count = index_count / 3;
+
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (size_t i = 0; i < index_count; i++) {
+            offsets[out[i] + 1]++;
+        }
+
+        for (size_t v = 0; v < vertex_count; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+
+        adjacency.resize(index_count);
+        std::vector<nstd::U32> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t f = 0; f < face_count; f++) {
+            for (int k = 0; k < 3; k++) {
+                adjacency[fill[out[f * 3 + k]]++] = (nstd::U32) f;
+            }
+        }
+
+        // an interior edge is seen from both its triangles, a < b keeps one of them
+        collapses.clear();
+        for (size_t i = 0; i < index_count; i += 3) {
+            for (int k = 0; k < 3; k++) {
+                nstd::U32 a = out[i + k];
+                nstd::U32 b = out[i + (k + 1) % 3];
+                bool locked_a = classes.kinds[a] == VERTEX_LOCKED;
+                bool locked_b = classes.kinds[b] == VERTEX_LOCKED;
+
+                if (a > b || (locked_a && locked_b)) {
+                    continue;
+                }
+
+                Quadric q = quadrics[groups[a]];
+                quadric_add(&q, &quadrics[groups[b]]);
+
+                double error_ab = locked_a ? max_error + 1.0 : quadric_error(&q, &points[b * 3]);
+                double error_ba = locked_b ? max_error + 1.0 : quadric_error(&q, &points[a * 3]);
+
+                if (error_ab <= error_ba) {
+                    collapses.push_back({ a, b, error_ab });
+                } else {
+                    collapses.push_back({ b, a, error_ba });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.error < b.error;
+        });
+
+        for (size_t v = 0; v < vertex_count; v++) {
+            remap[v] = (nstd::U32) v;
+        }
+
+        std::fill(touched.begin(), touched.end(), false);
+
+        // an interior collapse removes two triangles
+        size_t triangles_left = (index_count - target_index_count + 2) / 3;
+        size_t collapsed = 0;
+
+        for (const Collapse& collapse : collapses) {
+            if (collapse.error > max_error || collapsed * 2 >= triangles_left) {
+                break;
+            }
+
+            // a seam vertex takes its partner along onto the copy of to on the other side
+            nstd::U32 moves[2][2] = { { collapse.from, collapse.to }, { 0, 0 } };
+            int move_count = 1;
+
+            if (classes.kinds[collapse.from] == VERTEX_SEAM) {
+                moves[1][0] = classes.partners[collapse.from];
+                if (!seam_partner_target(collapse.from, collapse.to, out, offsets.data(), adjacency.data(), &classes, &moves[1][1])) {
+                    continue;
+                }
+
+                move_count = 2;
+            }
+
+            bool blocked = false;
+            for (int m = 0; m < move_count && !blocked; m++) {
+                const nstd::U32* triangles = &adjacency[offsets[moves[m][0]]];
+                nstd::U32 triangle_count = offsets[moves[m][0] + 1] - offsets[moves[m][0]];
+
+                blocked = touched[moves[m][0]] || touched[moves[m][1]]
+                    || collapse_flips(moves[m][0], moves[m][1], out, triangles, triangle_count, points.data());
+            }
+
+            if (blocked) {
+                continue;
+            }
+
+            // the neighbourhood is frozen for the rest of the pass so the flip test above stays valid
+            for (int m = 0; m < move_count; m++) {
+                const nstd::U32* triangles = &adjacency[offsets[moves[m][0]]];
+                nstd::U32 triangle_count = offsets[moves[m][0] + 1] - offsets[moves[m][0]];
+
+                for (nstd::U32 t = 0; t < triangle_count; t++) {
+                    for (int k = 0; k < 3; k++) {
+                        touched[out[triangles[t] * 3 + k]] = true;
+                    }
+                }
+
+                remap[moves[m][0]] = moves[m][1];
+            }
+
+            quadric_add(&quadrics[groups[collapse.to]], &quadrics[groups[collapse.from]]);
+            reached_error = std::max(reached_error, collapse.error);
+            collapsed++;
+        }
+
+        if (collapsed == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i < index_count; i += 3) {
+            GLuint a = remap[out[i + 0]];
+            GLuint b = remap[out[i + 1]];
+            GLuint c = remap[out[i + 2]];
+
+            if (a == b || b == c || c == a) {
+                continue;
+            }
+
+            out[write++] = a;
+            out[write++] = b;
+            out[write++] = c;
+        }
+
+        index_count = write;
+    }
+
+    if (result_error) {
+        *result_error = (float) sqrt(reached_error);
+    }
+
+    return index_count;
+}
+
+MeshSimplifier::Chain MeshSimplifier::build_lods(
+    const GLuint* indices,
+    size_t index_count,
+    const float* positions,
+    size_t position_stride,
+    size_t vertex_count,
+    const Settings* settings
+) {
+    Chain chain;
+    chain.indices.assign(indices, indices + index_count);
+    chain.levels.push_back({ 0, (nstd::U32) index_count, 0.0f });
+
+    std::vector<GLuint> level(index_count);
+
+    while ((int) chain.levels.size() < settings->max_levels) {
+        const Level previous = chain.levels.back();
+        const GLuint* source = chain.indices.data() + previous.first_index;
+
+        size_t target = (size_t) (previous.index_count * settings->ratio) / 3 * 3;
+        float error = 0.0f;
+
+        // errors of successive levels add up since each is measured against the level before
+        size_t count = simplify(
+            level.data(), source, previous.index_count,
+            positions, position_stride, vertex_count,
+            target, settings->max_error - previous.error, &error
+        );
+
+        if (count == 0 || (float) count > previous.index_count * (1.0f - min_reduction)) {
+            break;
+        }
+
+        float total_error = previous.error + error;
+
+        MeshOptimizer::optimize_vertex_cache(level.data(), count, vertex_count);
+
+        chain.levels.push_back({ (nstd::U32) chain.indices.size(), (nstd::U32) count, total_error });
+        chain.indices.insert(chain.indices.end(), level.begin(), level.begin() + count);
+    }
+
+    return chain;
+}
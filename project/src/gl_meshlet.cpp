@@ -0,0 +1,379 @@
+#include "main.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MESHLET_SSE2 1
+#endif
+
+MeshletSet::MeshletSet() {
+    this->padded_count = 0;
+}
+
+void MeshletSet::init(const Meshlet* meshlets, size_t count, nstd::U32 index_base) {
+    this->meshlets.assign(meshlets, meshlets + count);
+    this->padded_count = (count + 3) & ~(size_t) 3;
+
+    // padding clusters get a radius no plane test passes
+    this->cull_data.assign(CULL_FIELD_MAX * this->padded_count, 0.0f);
+    for (size_t i = count; i < this->padded_count; i++) {
+        this->cull_data[CULL_RADIUS * this->padded_count + i] = -1e30f;
+        this->cull_data[CULL_CUTOFF * this->padded_count + i] = 1.0f;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        Meshlet& meshlet = this->meshlets[i];
+        meshlet.first_index -= index_base;
+
+        float fields[CULL_FIELD_MAX] = {
+            meshlet.center[0], meshlet.center[1], meshlet.center[2], meshlet.radius,
+            meshlet.cone_apex[0], meshlet.cone_apex[1], meshlet.cone_apex[2],
+            meshlet.cone_axis[0], meshlet.cone_axis[1], meshlet.cone_axis[2],
+            meshlet.cone_cutoff,
+        };
+
+        for (int f = 0; f < CULL_FIELD_MAX; f++) {
+            this->cull_data[f * this->padded_count + i] = fields[f];
+        }
+    }
+}
+
+/*
+    building
+*/
+
+static glm::vec3 read_position(const float* positions, size_t stride, GLuint index) {
+    const float* p = (const float*) ((const char*) positions + index * stride);
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+// bounding sphere and normal cone of a finished cluster
+static void compute_bounds(
+    MeshletSet::Meshlet* meshlet,
+    const GLuint* indices,
+    const float* positions,
+    size_t stride
+) {
+    size_t index_count = meshlet->triangle_count * 3;
+    const GLuint* tri = indices + meshlet->first_index;
+
+    glm::vec3 lo = read_position(positions, stride, tri[0]);
+    glm::vec3 hi = lo;
+    for (size_t i = 1; i < index_count; i++) {
+        glm::vec3 p = read_position(positions, stride, tri[i]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+
+    glm::vec3 center = (lo + hi) * 0.5f;
+    float radius = 0.0f;
+    for (size_t i = 0; i < index_count; i++) {
+        radius = std::max(radius, glm::length(read_position(positions, stride, tri[i]) - center));
+    }
+
+    // the axis averages the triangle normals, the cutoff is the sine of the widest angle to it
+    std::vector<glm::vec3> normals;
+    glm::vec3 axis(0.0f);
+    for (size_t i = 0; i < index_count; i += 3) {
+        glm::vec3 a = read_position(positions, stride, tri[i + 0]);
+        glm::vec3 b = read_position(positions, stride, tri[i + 1]);
+        glm::vec3 c = read_position(positions, stride, tri[i + 2]);
+
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+    }
+
+    float axis_length = glm::length(axis);
+    axis = axis_length > 0.0f ? axis / axis_length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+    float min_dot = 1.0f;
+    for (const glm::vec3& normal : normals) {
+        min_dot = std::min(min_dot, glm::dot(normal, axis));
+    }
+
+    // the apex sits behind every triangle's plane along the axis so the test holds for the whole cluster
+    float max_t = 0.0f;
+    for (size_t i = 0, n = 0; i < index_count; i += 3) {
+        glm::vec3 a = read_position(positions, stride, tri[i + 0]);
+        glm::vec3 b = read_position(positions, stride, tri[i + 1]);
+        glm::vec3 c = read_position(positions, stride, tri[i + 2]);
+
+        if (glm::length(glm::cross(b - a, c - a)) == 0.0f) {
+            continue;
+        }
+
+        const glm::vec3& normal = normals[n++];
+        float along = glm::dot(axis, normal);
+        if (along > 0.0f) {
+            max_t = std::max(max_t, glm::dot(center - a, normal) / along);
+        }
+    }
+
+    glm::vec3 apex = center - axis * max_t;
+
+    for (int k = 0; k < 3; k++) {
+        meshlet->center[k] = center[k];
+        meshlet->cone_apex[k] = apex[k];
+        meshlet->cone_axis[k] = axis[k];
+    }
+
+    meshlet->radius = radius;
+
+    // normals spread past about 84 degrees leave nothing to cull
+    meshlet->cone_cutoff = min_dot <= 0.1f ? 1.0f : sqrtf(1.0f - min_dot * min_dot);
+}
+
+std::vector<MeshletSet::Meshlet> MeshletSet::build(
+    GLuint* out_indices,
+    const GLuint* indices,
+    size_t index_count,
+    const float* positions,
+    size_t position_stride,
+    size_t vertex_count
+) {
+    std::vector<Meshlet> meshlets;
+    size_t face_count = index_count / 3;
+    if (face_count == 0) {
+        return meshlets;
+    }
+
+    // triangles of each vertex
+    std::vector<nstd::U32> offsets(vertex_count + 1, 0);
+    for (size_t i = 0; i < face_count * 3; i++) {
+        offsets[indices[i] + 1]++;
+    }
+
+    for (size_t v = 0; v < vertex_count; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    std::vector<nstd::U32> adjacency(face_count * 3);
+    std::vector<nstd::U32> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t f = 0; f < face_count; f++) {
+        for (int k = 0; k < 3; k++) {
+            adjacency[fill[indices[f * 3 + k]]++] = (nstd::U32) f;
+        }
+    }
+
+    std::vector<bool> emitted(face_count, false);
+    std::vector<bool> in_meshlet(vertex_count, false);
+    std::vector<GLuint> meshlet_vertices;
+
+    Meshlet current = {};
+    size_t written = 0;
+    size_t cursor = 0;
+
+    auto finish = [&]() {
+        if (current.triangle_count == 0) {
+            return;
+        }
+
+        current.vertex_count = (nstd::U32) meshlet_vertices.size();
+        compute_bounds(&current, out_indices, positions, position_stride);
+        meshlets.push_back(current);
+
+        for (GLuint v : meshlet_vertices) {
+            in_meshlet[v] = false;
+        }
+
+        meshlet_vertices.clear();
+        current = {};
+        current.first_index = (nstd::U32) written;
+    };
+
+    for (size_t emitted_count = 0; emitted_count < face_count;) {
+        // prefer the neighbour sharing the most vertices with the cluster, ties go to the earlier triangle
+        size_t best = face_count;
+        int best_shared = 0;
+
+        for (GLuint v : meshlet_vertices) {
+            for (nstd::U32 a = offsets[v]; a < offsets[v + 1]; a++) {
+                nstd::U32 f = adjacency[a];
+                if (emitted[f]) {
+                    continue;
+                }
+
+                int shared = in_meshlet[indices[f * 3 + 0]] + in_meshlet[indices[f * 3 + 1]] + in_meshlet[indices[f * 3 + 2]];
+                if (shared > best_shared || (shared == best_shared && f < best)) {
+                    best = f;
+                    best_shared = shared;
+                }
+            }
+        }
+
+        // nothing connected, continue in input order
+        if (best == face_count) {
+            while (emitted[cursor]) {
+                cursor++;
+            }
+
+            best = cursor;
+            best_shared = 0;
+        }
+
+        size_t new_vertices = 3 - best_shared;
+        if (meshlet_vertices.size() + new_vertices > max_vertices || current.triangle_count + 1 > max_triangles) {
+            finish();
+            continue;
+        }
+
+        for (int k = 0; k < 3; k++) {
+            GLuint v = indices[best * 3 + k];
+            out_indices[written++] = v;
+
+            if (!in_meshlet[v]) {
+                in_meshlet[v] = true;
+                meshlet_vertices.push_back(v);
+            }
+        }
+
+        emitted[best] = true;
+        emitted_count++;
+        current.triangle_count++;
+    }
+
+    finish();
+    return meshlets;
+}
+
+/*
+    culling
+*/
+
+// culls clusters [begin, end), both multiples of 4
+static void cull_range(
+    const float* data,
+    size_t stride,
+    size_t count,
+    size_t begin,
+    size_t end,
+    const float planes[6][4],
+    glm::vec3 camera,
+    bool cone_culling,
+    std::vector<nstd::U32>* visible
+) {
+    const float* cx = data + MeshletSet::CULL_CENTER_X * stride;
+    const float* cy = data + MeshletSet::CULL_CENTER_Y * stride;
+    const float* cz = data + MeshletSet::CULL_CENTER_Z * stride;
+    const float* radius = data + MeshletSet::CULL_RADIUS * stride;
+    const float* px = data + MeshletSet::CULL_APEX_X * stride;
+    const float* py = data + MeshletSet::CULL_APEX_Y * stride;
+    const float* pz = data + MeshletSet::CULL_APEX_Z * stride;
+    const float* ax = data + MeshletSet::CULL_AXIS_X * stride;
+    const float* ay = data + MeshletSet::CULL_AXIS_Y * stride;
+    const float* az = data + MeshletSet::CULL_AXIS_Z * stride;
+    const float* cutoff = data + MeshletSet::CULL_CUTOFF * stride;
+
+#ifdef MESHLET_SSE2
+    for (size_t i = begin; i < end; i += 4) {
+        __m128 x = _mm_loadu_ps(cx + i);
+        __m128 y = _mm_loadu_ps(cy + i);
+        __m128 z = _mm_loadu_ps(cz + i);
+        __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[p][0])), _mm_mul_ps(y, _mm_set1_ps(planes[p][1]))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(planes[p][2])), _mm_set1_ps(planes[p][3]))
+            );
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg_r));
+        }
+
+        if (cone_culling) {
+            __m128 vx = _mm_sub_ps(_mm_loadu_ps(px + i), _mm_set1_ps(camera.x));
+            __m128 vy = _mm_sub_ps(_mm_loadu_ps(py + i), _mm_set1_ps(camera.y));
+            __m128 vz = _mm_sub_ps(_mm_loadu_ps(pz + i), _mm_set1_ps(camera.z));
+
+            __m128 along = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(ax + i)), _mm_mul_ps(vy, _mm_loadu_ps(ay + i))),
+                _mm_mul_ps(vz, _mm_loadu_ps(az + i))
+            );
+            __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+            __m128 backfacing = _mm_cmpge_ps(along, _mm_mul_ps(_mm_loadu_ps(cutoff + i), length));
+
+            inside = _mm_andnot_ps(backfacing, inside);
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int k = 0; mask && k < 4; k++, mask >>= 1) {
+            if ((mask & 1) && i + k < count) {
+                visible->push_back((nstd::U32) (i + k));
+            }
+        }
+    }
+#else
+    for (size_t i = begin; i < end && i < count; i++) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++) {
+            float d = planes[p][0] * cx[i] + planes[p][1] * cy[i] + planes[p][2] * cz[i] + planes[p][3];
+            inside = d >= -radius[i];
+        }
+
+        if (inside && cone_culling) {
+            glm::vec3 v = glm::vec3(px[i], py[i], pz[i]) - camera;
+            inside = glm::dot(v, glm::vec3(ax[i], ay[i], az[i])) < cutoff[i] * glm::length(v);
+        }
+
+        if (inside) {
+            visible->push_back((nstd::U32) i);
+        }
+    }
+#endif
+}
+
+void MeshletSet::cull(const glm::mat4& model_view_projection, glm::vec3 camera_position, bool cone_culling, std::vector<nstd::U32>* visible) const {
+    visible->clear();
+
+    // planes of a model view projection are in mesh space
+    float planes[6][4];
+    Camera::frustum_planes(model_view_projection, planes);
+
+    size_t count = this->meshlets.size();
+    size_t groups = this->padded_count / 4;
+    int workers = Parallel::worker_count(count, min_parallel_meshlets);
+
+    if (workers <= 1) {
+        cull_range(this->cull_data.data(), this->padded_count, count, 0, this->padded_count, planes, camera_position, cone_culling, visible);
+        return;
+    }
+
+    // each worker culls whole groups of 4, the slices are joined in order
+    std::vector<std::vector<nstd::U32>> slices(workers);
+    Parallel::for_range(groups, workers, [&](int worker, size_t first, size_t last) {
+        cull_range(this->cull_data.data(), this->padded_count, count, first * 4, last * 4, planes, camera_position, cone_culling, &slices[worker]);
+    });
+
+    for (const std::vector<nstd::U32>& slice : slices) {
+        visible->insert(visible->end(), slice.begin(), slice.end());
+    }
+}
+
+void MeshletSet::cull(const Camera* camera, const SceneObject* binding, std::vector<nstd::U32>* visible) const {
+    glm::mat4 model = binding->get_model_matrix();
+    glm::vec4 eye = glm::inverse(model) * glm::vec4(camera->object_binding->position, 1.0f);
+
+    // normals do not transform like positions under non uniform scale, the cones would be wrong
+    glm::vec3 scale = binding->scale;
+    bool uniform = fabsf(scale.x - scale.y) <= 1e-4f * fabsf(scale.x) && fabsf(scale.x - scale.z) <= 1e-4f * fabsf(scale.x);
+
+    cull(camera->get_perspective() * model, glm::vec3(eye.x, eye.y, eye.z), uniform, visible);
+}
+
+void MeshletSet::get_ranges(const std::vector<nstd::U32>& visible, std::vector<Range>* ranges) const {
+    ranges->clear();
+
+    for (nstd::U32 index : visible) {
+        const Meshlet& meshlet = this->meshlets[index];
+        nstd::U32 index_count = meshlet.triangle_count * 3;
+
+        if (!ranges->empty() && ranges->back().first_index + ranges->back().index_count == meshlet.first_index) {
+            ranges->back().index_count += index_count;
+        } else {
+            ranges->push_back({ meshlet.first_index, index_count });
+        }
+    }
+}
@@ -0,0 +1,1209 @@
+#include "main.hpp"
+
+/*
+    helpers
+*/
+
+static bool has_extension(const char* path, const char* extension) {
+    const char* ext = strrchr(path, '.');
+    return ext && strcmp(ext, extension) == 0;
+}
+
+// smooth normals from the triangles around each vertex, for meshes that come without
+static void generate_normals(ModelImporter::Part* part) {
+    for (Vertex& vertex : part->vertices) {
+        vertex.normal = glm::vec3(0.0f);
+    }
+
+    for (size_t i = 0; i + 2 < part->indices.size(); i += 3) {
+        Vertex& a = part->vertices[part->indices[i + 0]];
+        Vertex& b = part->vertices[part->indices[i + 1]];
+        Vertex& c = part->vertices[part->indices[i + 2]];
+
+        // area weighted, the cross product is not normalized
+        glm::vec3 normal = glm::cross(b.position - a.position, c.position - a.position);
+        a.normal += normal;
+        b.normal += normal;
+        c.normal += normal;
+    }
+
+    for (Vertex& vertex : part->vertices) {
+        float length = glm::length(vertex.normal);
+        vertex.normal = length > 0.0f ? vertex.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
+
+/*
+    loading
+*/
+
+bool ModelImporter::load(const char* path, Model* model, bool use_cache) {
+    std::string cache_path = std::string(path) + cache_extension;
+    model->parts.clear();
+
+    if (use_cache && read_cache(cache_path.c_str(), path, model)) {
+        LOGI("loaded model %s from cache", path);
+        return true;
+    }
+
+    bool loaded = false;
+    if (has_extension(path, ".obj")) {
+        loaded = load_obj(path, model);
+    } else if (has_extension(path, ".gltf") || has_extension(path, ".glb")) {
+        loaded = load_gltf(path, model);
+    } else {
+        LOGE("unknown model format %s", path);
+        return false;
+    }
+
+    if (!loaded) {
+        return false;
+    }
+
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+    for (const Part& part : model->parts) {
+        vertex_count += part.vertices.size();
+        index_count += part.indices.size();
+    }
+
+    LOGI("imported model %s, %zu parts, %zu vertices, %zu triangles", path, model->parts.size(), vertex_count, index_count / 3);
+
+    if (use_cache) {
+        write_cache(cache_path.c_str(), path, model);
+    }
+
+    return true;
+}
+
+/*
+    cache
+*/
+
+static size_t padded_name_length(size_t length) {
+    return (length + 7) & ~(size_t) 7;
+}
+
+bool ModelImporter::read_cache(const char* cache_path, const char* source_path, Model* model) {
+    FileStamp cache;
+
+    // no cache yet is the normal first load, not an error
+    if (!FileStamp::get(cache_path, &cache)) {
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(cache_path)) {
+        return false;
+    }
+
+    FileStamp source;
+    bool have_source = FileStamp::get(source_path, &source);
+
+    CacheHeader header;
+    if (file.size < sizeof(CacheHeader)) {
+        return false;
+    }
+
+    memcpy(&header, file.data, sizeof(CacheHeader));
+
+    // a cache without its source is still used, a changed source invalidates it
+    if (header.magic != cache_magic || header.version != cache_version || header.vertex_size != sizeof(Vertex)) {
+        return false;
+    }
+
+    if (have_source && (header.source_size != source.size || header.source_mtime != source.mtime)) {
+        LOGI("model cache %s is out of date", cache_path);
+        return false;
+    }
+
+    // every part needs at least its record, a larger count is a corrupt header
+    if (header.part_count > (file.size - sizeof(CacheHeader)) / sizeof(CachePart)) {
+        LOGE("model cache %s has a bad part count %u", cache_path, header.part_count);
+        return false;
+    }
+
+    size_t offset = sizeof(CacheHeader);
+    std::vector<Part> parts(header.part_count);
+
+    for (Part& part : parts) {
+        CachePart info;
+        if (offset + sizeof(CachePart) > file.size) {
+            LOGE("model cache %s is truncated", cache_path);
+            return false;
+        }
+
+        memcpy(&info, file.data + offset, sizeof(CachePart));
+        offset += sizeof(CachePart);
+
+        size_t name_size = padded_name_length(info.name_length);
+        size_t vertex_size = (size_t) info.vertex_count * sizeof(Vertex);
+        size_t index_size = (size_t) info.index_count * sizeof(GLuint);
+
+        if (offset + name_size + vertex_size + index_size > file.size) {
+            LOGE("model cache %s is truncated", cache_path);
+            return false;
+        }
+
+        part.name.assign(file.data + offset, info.name_length);
+        offset += name_size;
+
+        part.vertices.resize(info.vertex_count);
+        memcpy(part.vertices.data(), file.data + offset, vertex_size);
+        offset += vertex_size;
+
+        part.indices.resize(info.index_count);
+        memcpy(part.indices.data(), file.data + offset, index_size);
+        offset += index_size;
+
+        // indices go straight to the optimizer and gl, one past the vertices would read out of bounds
+        for (GLuint index : part.indices) {
+            if (index >= info.vertex_count) {
+                LOGE("model cache %s has an index out of range", cache_path);
+                return false;
+            }
+        }
+    }
+
+    model->parts = std::move(parts);
+    return true;
+}
+
+bool ModelImporter::write_cache(const char* cache_path, const char* source_path, const Model* model) {
+    CacheHeader header = {
+        .magic = cache_magic,
+        .version = cache_version,
+        .source_size = 0,
+        .source_mtime = 0,
+        .part_count = (nstd::U32) model->parts.size(),
+        .vertex_size = sizeof(Vertex),
+    };
+
+    FileStamp source;
+    if (!FileStamp::get(source_path, &source)) {
+        LOGE("failed to stat model %s", source_path);
+        return false;
+    }
+
+    header.source_size = source.size;
+    header.source_mtime = source.mtime;
+
+    FILE* file = fopen(cache_path, "wb");
+    if (!file) {
+        LOGE("failed to write model cache %s", cache_path);
+        return false;
+    }
+
+    static const char zeros[8] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (const Part& part : model->parts) {
+        CachePart info = {
+            .name_length = (nstd::U32) part.name.size(),
+            .vertex_count = (nstd::U32) part.vertices.size(),
+            .index_count = (nstd::U32) part.indices.size(),
+            .pad = 0,
+        };
+
+        size_t padding = padded_name_length(part.name.size()) - part.name.size();
+
+        ok = ok && fwrite(&info, sizeof(info), 1, file) == 1;
+        ok = ok && fwrite(part.name.data(), 1, part.name.size(), file) == part.name.size();
+        ok = ok && fwrite(zeros, 1, padding, file) == padding;
+        ok = ok && fwrite(part.vertices.data(), sizeof(Vertex), part.vertices.size(), file) == part.vertices.size();
+        ok = ok && fwrite(part.indices.data(), sizeof(GLuint), part.indices.size(), file) == part.indices.size();
+    }
+
+    fclose(file);
+
+    if (!ok) {
+        LOGE("failed to write model cache %s", cache_path);
+        remove(cache_path);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+    obj
+*/
+
+// cursor over a line of text, never reads past end
+typedef struct {
+    const char* at;
+    const char* end;
+} Cursor;
+
+static void skip_spaces(Cursor* c) {
+    while (c->at < c->end && (*c->at == ' ' || *c->at == '\t' || *c->at == '\r')) {
+        c->at++;
+    }
+}
+
+static double parse_double(Cursor* c) {
+    skip_spaces(c);
+
+    bool negative = false;
+    if (c->at < c->end && (*c->at == '-' || *c->at == '+')) {
+        negative = *c->at == '-';
+        c->at++;
+    }
+
+    double value = 0.0;
+    while (c->at < c->end && *c->at >= '0' && *c->at <= '9') {
+        value = value * 10.0 + (*c->at++ - '0');
+    }
+
+    if (c->at < c->end && *c->at == '.') {
+        c->at++;
+
+        double scale = 0.1;
+        while (c->at < c->end && *c->at >= '0' && *c->at <= '9') {
+            value += (*c->at++ - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+
+    if (c->at < c->end && (*c->at == 'e' || *c->at == 'E')) {
+        c->at++;
+
+        bool negative_exponent = false;
+        if (c->at < c->end && (*c->at == '-' || *c->at == '+')) {
+            negative_exponent = *c->at == '-';
+            c->at++;
+        }
+
+        int exponent = 0;
+        while (c->at < c->end && *c->at >= '0' && *c->at <= '9') {
+            exponent = exponent * 10 + (*c->at++ - '0');
+        }
+
+        value *= pow(10.0, negative_exponent ? -exponent : exponent);
+    }
+
+    return negative ? -value : value;
+}
+
+static float parse_float(Cursor* c) {
+    return (float) parse_double(c);
+}
+
+// obj index, 0 when absent
+static int parse_int(Cursor* c) {
+    bool negative = false;
+    if (c->at < c->end && *c->at == '-') {
+        negative = true;
+        c->at++;
+    }
+
+    int value = 0;
+    while (c->at < c->end && *c->at >= '0' && *c->at <= '9') {
+        value = value * 10 + (*c->at++ - '0');
+    }
+
+    return negative ? -value : value;
+}
+
+static bool starts_with(const Cursor* c, const char* token) {
+    size_t length = strlen(token);
+    return (size_t) (c->end - c->at) >= length && memcmp(c->at, token, length) == 0;
+}
+
+// resolves a 1 based or negative obj index against the number of elements declared so far
+static nstd::S64 resolve_index(int index, nstd::S64 declared) {
+    if (index > 0) {
+        return index - 1;
+    }
+
+    if (index < 0) {
+        return declared + index;
+    }
+
+    return -1;
+}
+
+typedef struct {
+    nstd::S64 position;
+    nstd::S64 uv;
+    nstd::S64 normal;
+} ObjCorner;
+
+typedef struct {
+    std::string name;
+    size_t first_corner;
+} ObjGroup;
+
+// one worker's slice of the file, declarations are numbered from the counts of earlier chunks
+typedef struct {
+    const char* begin;
+    const char* end;
+    nstd::S64 counts[3];        // v, vt, vn lines in the chunk
+    nstd::S64 bases[3];         // declarations before the chunk
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;      // triangulated, three per triangle
+    std::vector<ObjGroup> groups;
+} ObjChunk;
+
+static const char* next_line(const char* at, const char* end) {
+    const char* newline = (const char*) memchr(at, '\n', end - at);
+    return newline ? newline + 1 : end;
+}
+
+static void count_obj_chunk(ObjChunk* chunk) {
+    chunk->counts[0] = chunk->counts[1] = chunk->counts[2] = 0;
+
+    for (const char* line = chunk->begin; line < chunk->end; line = next_line(line, chunk->end)) {
+        Cursor c = { line, chunk->end };
+        skip_spaces(&c);
+
+        if (starts_with(&c, "v ") || starts_with(&c, "v\t")) {
+            chunk->counts[0]++;
+        } else if (starts_with(&c, "vt")) {
+            chunk->counts[1]++;
+        } else if (starts_with(&c, "vn")) {
+            chunk->counts[2]++;
+        }
+    }
+}
+
+static void parse_obj_chunk(ObjChunk* chunk) {
+    chunk->positions.reserve(chunk->counts[0]);
+    chunk->uvs.reserve(chunk->counts[1]);
+    chunk->normals.reserve(chunk->counts[2]);
+
+    std::vector<ObjCorner> polygon;
+
+    for (const char* line = chunk->begin; line < chunk->end;) {
+        const char* line_end = next_line(line, chunk->end);
+        Cursor c = { line, line_end[-1] == '\n' ? line_end - 1 : line_end };
+        line = line_end;
+
+        skip_spaces(&c);
+
+        if (starts_with(&c, "v ") || starts_with(&c, "v\t")) {
+            c.at += 2;
+            float x = parse_float(&c);
+            float y = parse_float(&c);
+            float z = parse_float(&c);
+            chunk->positions.push_back(glm::vec3(x, y, z));
+        } else if (starts_with(&c, "vt")) {
+            c.at += 2;
+            float u = parse_float(&c);
+            float v = parse_float(&c);
+            chunk->uvs.push_back(glm::vec2(u, v));
+        } else if (starts_with(&c, "vn")) {
+            c.at += 2;
+            float x = parse_float(&c);
+            float y = parse_float(&c);
+            float z = parse_float(&c);
+            chunk->normals.push_back(glm::vec3(x, y, z));
+        } else if (starts_with(&c, "f ") || starts_with(&c, "f\t")) {
+            c.at += 2;
+            polygon.clear();
+
+            nstd::S64 declared[3] = {
+                chunk->bases[0] + (nstd::S64) chunk->positions.size(),
+                chunk->bases[1] + (nstd::S64) chunk->uvs.size(),
+                chunk->bases[2] + (nstd::S64) chunk->normals.size(),
+            };
+
+            // corners are v, v/vt, v//vn or v/vt/vn
+            for (skip_spaces(&c); c.at < c.end; skip_spaces(&c)) {
+                ObjCorner corner = { -1, -1, -1 };
+                corner.position = resolve_index(parse_int(&c), declared[0]);
+
+                if (c.at < c.end && *c.at == '/') {
+                    c.at++;
+                    corner.uv = resolve_index(parse_int(&c), declared[1]);
+
+                    if (c.at < c.end && *c.at == '/') {
+                        c.at++;
+                        corner.normal = resolve_index(parse_int(&c), declared[2]);
+                    }
+                }
+
+                // stop at anything that is not an index, trailing comments included
+                if (corner.position < 0) {
+                    break;
+                }
+
+                polygon.push_back(corner);
+            }
+
+            // fan triangulation of convex polygons
+            for (size_t i = 2; i < polygon.size(); i++) {
+                chunk->corners.push_back(polygon[0]);
+                chunk->corners.push_back(polygon[i - 1]);
+                chunk->corners.push_back(polygon[i]);
+            }
+        } else if (starts_with(&c, "o ") || starts_with(&c, "g ")) {
+            c.at += 2;
+            skip_spaces(&c);
+            chunk->groups.push_back({ std::string(c.at, c.end - c.at), chunk->corners.size() });
+        }
+    }
+}
+
+// a group's corners across chunks
+typedef struct {
+    std::string name;
+    std::vector<std::pair<const ObjChunk*, std::pair<size_t, size_t>>> ranges;
+} ObjPartRanges;
+
+// expands a group's corners into vertices and welds the copies of shared corners
+static void weld_obj_part(
+    const ObjPartRanges* ranges,
+    const std::vector<const glm::vec3*>& positions,
+    const std::vector<const glm::vec2*>& uvs,
+    const std::vector<const glm::vec3*>& normals,
+    ModelImporter::Part* part,
+    int threads
+) {
+    std::vector<Vertex> soup;
+    bool missing_normals = false;
+
+    part->name = ranges->name;
+
+    for (const auto& [chunk, range] : ranges->ranges) {
+        for (size_t i = range.first; i < range.second; i++) {
+            const ObjCorner& corner = chunk->corners[i];
+
+            Vertex vertex;
+            vertex.position = corner.position < (nstd::S64) positions.size() ? *positions[corner.position] : glm::vec3(0.0f);
+            vertex.normal = glm::vec3(0.0f);
+            vertex.color = glm::vec4(1.0f);
+            vertex.texUV = glm::vec2(0.0f);
+
+            if (corner.uv >= 0 && corner.uv < (nstd::S64) uvs.size()) {
+                vertex.texUV = *uvs[corner.uv];
+            }
+
+            if (corner.normal >= 0 && corner.normal < (nstd::S64) normals.size()) {
+                vertex.normal = *normals[corner.normal];
+            } else {
+                missing_normals = true;
+            }
+
+            soup.push_back(vertex);
+        }
+    }
+
+    VertexWelder::weld(soup.data(), soup.size(), &part->vertices, &part->indices, 0.0f, threads);
+
+    if (missing_normals) {
+        generate_normals(part);
+    }
+}
+
+bool ModelImporter::load_obj(const char* path, Model* model, int threads) {
+    MappedFile file;
+    if (!file.open(path)) {
+        LOGE("failed to open model %s", path);
+        return false;
+    }
+
+    if (threads <= 0) {
+        threads = Parallel::thread_count();
+    }
+
+    // split at line boundaries into chunks of at least min_chunk_size
+    size_t chunk_count = nstd::max((size_t) 1, nstd::min((size_t) threads, file.size / min_chunk_size));
+    std::vector<ObjChunk> chunks(chunk_count);
+
+    const char* begin = file.data;
+    const char* end = file.data + file.size;
+
+    for (size_t i = 0; i < chunk_count; i++) {
+        const char* split = i + 1 == chunk_count ? end : file.data + file.size * (i + 1) / chunk_count;
+        split = split < begin ? begin : split;
+
+        if (split < end) {
+            split = next_line(split, end);
+        }
+
+        chunks[i].begin = begin;
+        chunks[i].end = split;
+        begin = split;
+    }
+
+    // a first pass counts declarations so each chunk knows its base for relative indices
+    Parallel::for_range(chunk_count, threads, [&chunks](int, size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            count_obj_chunk(&chunks[i]);
+        }
+    });
+
+    nstd::S64 bases[3] = { 0, 0, 0 };
+    for (ObjChunk& chunk : chunks) {
+        for (int k = 0; k < 3; k++) {
+            chunk.bases[k] = bases[k];
+            bases[k] += chunk.counts[k];
+        }
+    }
+
+    Parallel::for_range(chunk_count, threads, [&chunks](int, size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            parse_obj_chunk(&chunks[i]);
+        }
+    });
+
+    // flat views over all chunks' declarations
+    std::vector<const glm::vec3*> positions;
+    std::vector<const glm::vec2*> uvs;
+    std::vector<const glm::vec3*> normals;
+    positions.reserve(bases[0]);
+    uvs.reserve(bases[1]);
+    normals.reserve(bases[2]);
+
+    for (const ObjChunk& chunk : chunks) {
+        for (const glm::vec3& p : chunk.positions) positions.push_back(&p);
+        for (const glm::vec2& t : chunk.uvs) uvs.push_back(&t);
+        for (const glm::vec3& n : chunk.normals) normals.push_back(&n);
+    }
+
+    // groups may continue across chunk borders, corners before the first group form an unnamed part
+    std::vector<ObjPartRanges> part_ranges(1);
+    for (const ObjChunk& chunk : chunks) {
+        size_t start = 0;
+
+        for (const ObjGroup& group : chunk.groups) {
+            if (group.first_corner > start) {
+                part_ranges.back().ranges.push_back({ &chunk, { start, group.first_corner } });
+            }
+
+            if (!part_ranges.back().ranges.empty()) {
+                part_ranges.push_back({});
+            }
+
+            part_ranges.back().name = group.name;
+            start = group.first_corner;
+        }
+
+        if (chunk.corners.size() > start) {
+            part_ranges.back().ranges.push_back({ &chunk, { start, chunk.corners.size() } });
+        }
+    }
+
+    if (part_ranges.back().ranges.empty()) {
+        part_ranges.pop_back();
+    }
+
+    // parts weld independently, a single part gets every thread to itself
+    std::vector<Part> parts(part_ranges.size());
+    int part_threads = parts.size() == 1 ? threads : 1;
+    Parallel::for_range(parts.size(), threads, [&](int, size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            weld_obj_part(&part_ranges[i], positions, uvs, normals, &parts[i], part_threads);
+        }
+    });
+
+    model->parts = std::move(parts);
+    return true;
+}
+
+/*
+    json, enough of it for gltf
+*/
+
+struct Json {
+    typedef enum {
+        JSON_NULL,
+        JSON_BOOL,
+        JSON_NUMBER,
+        JSON_STRING,
+        JSON_ARRAY,
+        JSON_OBJECT,
+    } Type;
+
+    Type type = JSON_NULL;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> items;
+    std::vector<std::string> keys;      // parallel to items for objects
+
+    const Json* get(const char* key) const {
+        for (size_t i = 0; i < this->keys.size(); i++) {
+            if (this->keys[i] == key) {
+                return &this->items[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    const Json* at(size_t index) const {
+        return index < this->items.size() ? &this->items[index] : nullptr;
+    }
+
+    double number_or(const char* key, double fallback) const {
+        const Json* value = get(key);
+        return value && value->type == JSON_NUMBER ? value->number : fallback;
+    }
+};
+
+static void json_skip(Cursor* c) {
+    while (c->at < c->end && (*c->at == ' ' || *c->at == '\t' || *c->at == '\r' || *c->at == '\n')) {
+        c->at++;
+    }
+}
+
+static bool json_parse(Cursor* c, Json* out, int depth);
+
+static bool json_parse_string(Cursor* c, std::string* out) {
+    // opening quote already checked
+    c->at++;
+
+    while (c->at < c->end && *c->at != '"') {
+        char ch = *c->at++;
+        if (ch != '\\') {
+            out->push_back(ch);
+            continue;
+        }
+
+        if (c->at >= c->end) {
+            return false;
+        }
+
+        char escape = *c->at++;
+        switch (escape) {
+            case 'n': out->push_back('\n'); break;
+            case 't': out->push_back('\t'); break;
+            case 'r': out->push_back('\r'); break;
+            case 'b': out->push_back('\b'); break;
+            case 'f': out->push_back('\f'); break;
+            case 'u': {
+                if (c->end - c->at < 4) {
+                    return false;
+                }
+
+                unsigned int code = (unsigned int) strtoul(std::string(c->at, 4).c_str(), nullptr, 16);
+                c->at += 4;
+
+                // utf-8 of the basic plane, names and uris rarely need more
+                if (code < 0x80) {
+                    out->push_back((char) code);
+                } else if (code < 0x800) {
+                    out->push_back((char) (0xC0 | (code >> 6)));
+                    out->push_back((char) (0x80 | (code & 0x3F)));
+                } else {
+                    out->push_back((char) (0xE0 | (code >> 12)));
+                    out->push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+                    out->push_back((char) (0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+            default: out->push_back(escape); break;
+        }
+    }
+
+    if (c->at >= c->end) {
+        return false;
+    }
+
+    c->at++;
+    return true;
+}
+
+static bool json_parse(Cursor* c, Json* out, int depth) {
+    if (depth > 64) {
+        return false;
+    }
+
+    json_skip(c);
+    if (c->at >= c->end) {
+        return false;
+    }
+
+    char ch = *c->at;
+
+    if (ch == '{' || ch == '[') {
+        bool object = ch == '{';
+        char close = object ? '}' : ']';
+        out->type = object ? Json::JSON_OBJECT : Json::JSON_ARRAY;
+        c->at++;
+
+        json_skip(c);
+        if (c->at < c->end && *c->at == close) {
+            c->at++;
+            return true;
+        }
+
+        for (;;) {
+            if (object) {
+                json_skip(c);
+                if (c->at >= c->end || *c->at != '"') {
+                    return false;
+                }
+
+                out->keys.emplace_back();
+                if (!json_parse_string(c, &out->keys.back())) {
+                    return false;
+                }
+
+                json_skip(c);
+                if (c->at >= c->end || *c->at != ':') {
+                    return false;
+                }
+
+                c->at++;
+            }
+
+            out->items.emplace_back();
+            if (!json_parse(c, &out->items.back(), depth + 1)) {
+                return false;
+            }
+
+            json_skip(c);
+            if (c->at < c->end && *c->at == ',') {
+                c->at++;
+                continue;
+            }
+
+            if (c->at < c->end && *c->at == close) {
+                c->at++;
+                return true;
+            }
+
+            return false;
+        }
+    }
+
+    if (ch == '"') {
+        out->type = Json::JSON_STRING;
+        return json_parse_string(c, &out->string);
+    }
+
+    if (starts_with(c, "true") || starts_with(c, "false")) {
+        out->type = Json::JSON_BOOL;
+        out->number = ch == 't' ? 1.0 : 0.0;
+        c->at += ch == 't' ? 4 : 5;
+        return true;
+    }
+
+    if (starts_with(c, "null")) {
+        out->type = Json::JSON_NULL;
+        c->at += 4;
+        return true;
+    }
+
+    out->type = Json::JSON_NUMBER;
+    const char* start = c->at;
+    out->number = parse_double(c);
+    return c->at != start;
+}
+
+/*
+    gltf
+*/
+
+static constexpr nstd::U32 glb_magic = 0x46546C67;       // "glTF"
+static constexpr nstd::U32 glb_chunk_json = 0x4E4F534A;  // "JSON"
+static constexpr nstd::U32 glb_chunk_bin = 0x004E4942;   // "BIN"
+
+static constexpr int gltf_unsigned_byte = 5121;
+static constexpr int gltf_unsigned_short = 5123;
+static constexpr int gltf_unsigned_int = 5125;
+static constexpr int gltf_float = 5126;
+static constexpr int gltf_triangles = 4;
+
+static bool base64_decode(const char* data, size_t length, std::vector<nstd::U8>* out) {
+    nstd::U32 bits = 0;
+    int count = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        char ch = data[i];
+        int value;
+
+        if (ch >= 'A' && ch <= 'Z') value = ch - 'A';
+        else if (ch >= 'a' && ch <= 'z') value = ch - 'a' + 26;
+        else if (ch >= '0' && ch <= '9') value = ch - '0' + 52;
+        else if (ch == '+') value = 62;
+        else if (ch == '/') value = 63;
+        else if (ch == '=') break;
+        else return false;
+
+        bits = (bits << 6) | (nstd::U32) value;
+        count += 6;
+
+        if (count >= 8) {
+            count -= 8;
+            out->push_back((nstd::U8) (bits >> count));
+        }
+    }
+
+    return true;
+}
+
+static bool read_file(const char* path, std::vector<nstd::U8>* out) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    out->assign(file.data, file.data + file.size);
+    return true;
+}
+
+// a typed view of an accessor's elements
+typedef struct {
+    const nstd::U8* data;
+    size_t count;
+    size_t stride;
+    int component_type;
+    int components;
+    bool normalized;
+} GltfAccessor;
+
+static int gltf_component_size(int component_type) {
+    switch (component_type) {
+        case gltf_unsigned_byte: return 1;
+        case gltf_unsigned_short: return 2;
+        case gltf_unsigned_int: return 4;
+        case gltf_float: return 4;
+        default: return 0;
+    }
+}
+
+static int gltf_type_components(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+// a non negative integer that fits 32 bits, anything else would be undefined to cast
+static bool json_index(const Json* value, size_t* out) {
+    if (!value || value->type != Json::JSON_NUMBER || !(value->number >= 0.0 && value->number <= 4294967295.0) || value->number != floor(value->number)) {
+        return false;
+    }
+
+    *out = (size_t) value->number;
+    return true;
+}
+
+// an optional index of an object, fallback when the key is missing
+static bool json_index_or(const Json* object, const char* key, size_t fallback, size_t* out) {
+    const Json* value = object->get(key);
+    if (!value) {
+        *out = fallback;
+        return true;
+    }
+
+    return json_index(value, out);
+}
+
+// what accessors without a buffer view read, large enough for any element type
+static const nstd::U8 gltf_zeros[16] = {};
+
+static bool gltf_accessor(const Json* root, const std::vector<std::vector<nstd::U8>>& buffers, const Json* reference, GltfAccessor* out) {
+    const Json* accessors = root->get("accessors");
+    const Json* views = root->get("bufferViews");
+
+    size_t index;
+    const Json* accessor = accessors && json_index(reference, &index) ? accessors->at(index) : nullptr;
+    if (!accessor) {
+        return false;
+    }
+
+    const Json* type = accessor->get("type");
+    const Json* normalized = accessor->get("normalized");
+    out->component_type = (int) accessor->number_or("componentType", 0);
+    out->components = type ? gltf_type_components(type->string) : 0;
+    out->normalized = normalized && normalized->number != 0.0;
+
+    int component_size = gltf_component_size(out->component_type);
+    if (!component_size || !out->components || !json_index(accessor->get("count"), &out->count)) {
+        return false;
+    }
+
+    // sparse accessors patch their base values, reading only the base would be silently wrong
+    if (accessor->get("sparse")) {
+        return false;
+    }
+
+    // an accessor without a view is all zeros
+    const Json* view_index = accessor->get("bufferView");
+    if (!view_index) {
+        out->data = gltf_zeros;
+        out->stride = 0;
+        return true;
+    }
+
+    size_t view_at;
+    const Json* view = views && json_index(view_index, &view_at) ? views->at(view_at) : nullptr;
+    if (!view) {
+        return false;
+    }
+
+    size_t buffer, view_offset, accessor_offset;
+    size_t element_size = (size_t) component_size * out->components;
+
+    if (!json_index_or(view, "buffer", 0, &buffer) || 
+        !json_index_or(view, "byteOffset", 0, &view_offset) || 
+        !json_index_or(accessor, "byteOffset", 0, &accessor_offset) || 
+        !json_index_or(view, "byteStride", element_size, &out->stride)) {
+        return false;
+    }
+
+    size_t offset = view_offset + accessor_offset;
+
+    if (buffer >= buffers.size() || out->count == 0) {
+        return out->count == 0;
+    }
+
+    if (offset + out->stride * (out->count - 1) + element_size > buffers[buffer].size()) {
+        return false;
+    }
+
+    out->data = buffers[buffer].data() + offset;
+    return true;
+}
+
+// component of an element as float, normalized integers map to [0, 1]
+static float gltf_read_float(const GltfAccessor* accessor, size_t element, int component) {
+    const nstd::U8* p = accessor->data + element * accessor->stride;
+
+    switch (accessor->component_type) {
+        case gltf_float: {
+            float value;
+            memcpy(&value, p + component * 4, 4);
+            return value;
+        }
+        case gltf_unsigned_byte: {
+            float value = p[component];
+            return accessor->normalized ? value / 255.0f : value;
+        }
+        case gltf_unsigned_short: {
+            nstd::U16 value;
+            memcpy(&value, p + component * 2, 2);
+            return accessor->normalized ? value / 65535.0f : value;
+        }
+        default: return 0.0f;
+    }
+}
+
+static GLuint gltf_read_index(const GltfAccessor* accessor, size_t element) {
+    const nstd::U8* p = accessor->data + element * accessor->stride;
+
+    switch (accessor->component_type) {
+        case gltf_unsigned_byte: return p[0];
+        case gltf_unsigned_short: {
+            nstd::U16 value;
+            memcpy(&value, p, 2);
+            return value;
+        }
+        case gltf_unsigned_int: {
+            nstd::U32 value;
+            memcpy(&value, p, 4);
+            return value;
+        }
+        default: return 0;
+    }
+}
+
+static bool gltf_primitive(
+    const Json* root,
+    const std::vector<std::vector<nstd::U8>>& buffers,
+    const Json* primitive,
+    ModelImporter::Part* part
+) {
+    const Json* attributes = primitive->get("attributes");
+    const Json* position = attributes ? attributes->get("POSITION") : nullptr;
+    if (!position) {
+        return false;
+    }
+
+    GltfAccessor positions;
+    if (!gltf_accessor(root, buffers, position, &positions) || positions.components != 3) {
+        return false;
+    }
+
+    GltfAccessor normals = {};
+    GltfAccessor uvs = {};
+    GltfAccessor colors = {};
+
+    const Json* normal = attributes->get("NORMAL");
+    const Json* uv = attributes->get("TEXCOORD_0");
+    const Json* color = attributes->get("COLOR_0");
+
+    bool has_normals = normal && gltf_accessor(root, buffers, normal, &normals) && normals.count == positions.count;
+    bool has_uvs = uv && gltf_accessor(root, buffers, uv, &uvs) && uvs.count == positions.count;
+    bool has_colors = color && gltf_accessor(root, buffers, color, &colors) && colors.count == positions.count;
+
+    part->vertices.resize(positions.count);
+    for (size_t v = 0; v < positions.count; v++) {
+        Vertex& vertex = part->vertices[v];
+        vertex.position = glm::vec3(gltf_read_float(&positions, v, 0), gltf_read_float(&positions, v, 1), gltf_read_float(&positions, v, 2));
+        vertex.normal = has_normals
+            ? glm::vec3(gltf_read_float(&normals, v, 0), gltf_read_float(&normals, v, 1), gltf_read_float(&normals, v, 2))
+            : glm::vec3(0.0f);
+        vertex.texUV = has_uvs ? glm::vec2(gltf_read_float(&uvs, v, 0), gltf_read_float(&uvs, v, 1)) : glm::vec2(0.0f);
+        vertex.color = glm::vec4(1.0f);
+
+        if (has_colors) {
+            vertex.color = glm::vec4(
+                gltf_read_float(&colors, v, 0),
+                gltf_read_float(&colors, v, 1),
+                gltf_read_float(&colors, v, 2),
+                colors.components == 4 ? gltf_read_float(&colors, v, 3) : 1.0f
+            );
+        }
+    }
+
+    const Json* indices = primitive->get("indices");
+    if (indices) {
+        GltfAccessor index_data;
+        if (!gltf_accessor(root, buffers, indices, &index_data) || index_data.components != 1) {
+            return false;
+        }
+
+        part->indices.resize(index_data.count);
+        for (size_t i = 0; i < index_data.count; i++) {
+            part->indices[i] = gltf_read_index(&index_data, i);
+
+            if (part->indices[i] >= positions.count) {
+                return false;
+            }
+        }
+    } else {
+        // unindexed primitives are triangle soups, weld them so shared corners are transformed once
+        part->vertices.resize(positions.count - positions.count % 3);
+        std::vector<Vertex> soup = std::move(part->vertices);
+        VertexWelder::weld(soup.data(), soup.size(), &part->vertices, &part->indices, 0.0f, 1);
+    }
+
+    part->indices.resize(part->indices.size() - part->indices.size() % 3);
+
+    if (!has_normals) {
+        generate_normals(part);
+    }
+
+    return true;
+}
+
+bool ModelImporter::load_gltf(const char* path, Model* model, int threads) {
+    std::vector<nstd::U8> file;
+    if (!read_file(path, &file)) {
+        LOGE("failed to open model %s", path);
+        return false;
+    }
+
+    if (threads <= 0) {
+        threads = Parallel::thread_count();
+    }
+
+    Cursor json = { (const char*) file.data(), (const char*) file.data() + file.size() };
+    std::vector<std::vector<nstd::U8>> buffers;
+
+    // glb holds the json and the first buffer in chunks of one file
+    nstd::U32 magic = 0;
+    if (file.size() >= 12) {
+        memcpy(&magic, file.data(), 4);
+    }
+
+    if (magic == glb_magic) {
+        size_t offset = 12;
+        json.end = json.at;
+
+        while (offset + 8 <= file.size()) {
+            nstd::U32 length;
+            nstd::U32 type;
+            memcpy(&length, file.data() + offset, 4);
+            memcpy(&type, file.data() + offset + 4, 4);
+            offset += 8;
+
+            if (offset + length > file.size()) {
+                break;
+            }
+
+            if (type == glb_chunk_json) {
+                json = { (const char*) file.data() + offset, (const char*) file.data() + offset + length };
+            } else if (type == glb_chunk_bin && buffers.empty()) {
+                buffers.emplace_back(file.data() + offset, file.data() + offset + length);
+            }
+
+            offset += length;
+        }
+    }
+
+    Json root;
+    if (!json_parse(&json, &root, 0) || root.type != Json::JSON_OBJECT) {
+        LOGE("failed to parse gltf %s", path);
+        return false;
+    }
+
+    // external buffers are relative to the gltf file
+    std::string directory(path);
+    size_t slash = directory.find_last_of("/\\");
+    directory = slash == std::string::npos ? "" : directory.substr(0, slash + 1);
+
+    const Json* buffer_list = root.get("buffers");
+    for (size_t i = buffer_list ? buffers.size() : 0; buffer_list && i < buffer_list->items.size(); i++) {
+        const Json* uri = buffer_list->items[i].get("uri");
+        buffers.emplace_back();
+
+        if (!uri) {
+            continue;
+        }
+
+        const std::string& location = uri->string;
+        if (location.compare(0, 5, "data:") == 0) {
+            size_t comma = location.find(',');
+            if (comma == std::string::npos || !base64_decode(location.data() + comma + 1, location.size() - comma - 1, &buffers.back())) {
+                LOGE("bad data uri in gltf %s", path);
+                return false;
+            }
+        } else if (!read_file((directory + location).c_str(), &buffers.back())) {
+            LOGE("failed to open gltf buffer %s", location.c_str());
+            return false;
+        }
+    }
+
+    // triangle primitives of all meshes, converted in parallel
+    std::vector<std::pair<const Json*, std::string>> primitives;
+    const Json* meshes = root.get("meshes");
+
+    for (size_t m = 0; meshes && m < meshes->items.size(); m++) {
+        const Json* mesh = &meshes->items[m];
+        const Json* name = mesh->get("name");
+        const Json* list = mesh->get("primitives");
+
+        for (size_t p = 0; list && p < list->items.size(); p++) {
+            const Json* primitive = &list->items[p];
+
+            if ((int) primitive->number_or("mode", gltf_triangles) != gltf_triangles) {
+                continue;
+            }
+
+            std::string part_name = name ? name->string : "mesh" + std::to_string(m);
+            primitives.push_back({ primitive, list->items.size() > 1 ? part_name + "." + std::to_string(p) : part_name });
+        }
+    }
+
+    std::vector<Part> parts(primitives.size());
+    std::vector<char> valid(primitives.size(), 0);
+
+    Parallel::for_range(primitives.size(), threads, [&](int, size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            parts[i].name = primitives[i].second;
+            valid[i] = gltf_primitive(&root, buffers, primitives[i].first, &parts[i]);
+        }
+    });
+
+    model->parts.clear();
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (!valid[i]) {
+            LOGE("skipped unsupported gltf primitive %s", parts[i].name.c_str());
+            continue;
+        }
+
+        model->parts.push_back(std::move(parts[i]));
+    }
+
+    return true;
+}
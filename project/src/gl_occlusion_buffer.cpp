@@ -0,0 +1,477 @@
+#include "main.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#endif
+
+// pixels past the buffer edges an occluder vertex may reach, further ones would cost the edge
+// functions their precision and are dropped like near plane crossings
+static constexpr float guard_band = 16384.0f;
+
+// a pixel bound clamped to just outside the buffer, so converting it to int stays defined
+static float clamp_bound(float value, int size) {
+    return std::min(std::max(value, -1.0f), (float) size + 1.0f);
+}
+
+OcclusionBuffer::OcclusionBuffer() {
+    this->width = 0;
+    this->height = 0;
+    this->tiles_x = 0;
+    this->tiles_y = 0;
+    this->view_projection = glm::mat4(1.0f);
+    this->min_w = 0.0f;
+    this->last_frame = {};
+    this->frame = {};
+}
+
+void OcclusionBuffer::init(int width, int height) {
+    this->tiles_x = (width + tile_size - 1) / tile_size;
+    this->tiles_y = (height + tile_size - 1) / tile_size;
+    this->width = this->tiles_x * tile_size;
+    this->height = this->tiles_y * tile_size;
+
+    this->depth.assign((size_t) this->width * this->height, 1.0f);
+    this->tile_depth.assign((size_t) this->tiles_x * this->tiles_y, 1.0f);
+}
+
+void OcclusionBuffer::begin_frame(const glm::mat4& view_projection, float near_plane) {
+    this->view_projection = view_projection;
+    this->min_w = near_plane;
+    this->occluders.clear();
+
+    this->last_frame = this->frame;
+    this->frame = {};
+}
+
+void OcclusionBuffer::add_occluder(
+    const void* vertices,
+    size_t stride,
+    size_t vertex_count,
+    const GLuint* indices,
+    size_t index_count,
+    const glm::mat4& model
+) {
+    this->occluders.push_back({ (const nstd::U8*) vertices, stride, vertex_count, indices, index_count, model });
+}
+
+// twice the signed area of the turn a -> b -> c
+static float turn(const float* x, const float* y, int a, int b, int c) {
+    return (x[b] - x[a]) * (y[c] - y[b]) - (y[b] - y[a]) * (x[c] - x[b]);
+}
+
+// merges triangle t with its neighbour s across their shared edge when the quad is convex on screen,
+// the quad keeps t's winding with s's free vertex between the shared ones
+static bool merge_quad(
+    const OcclusionBuffer::Polygon& t,
+    const GLuint* t_indices,
+    const OcclusionBuffer::Polygon& s,
+    const GLuint* s_indices,
+    OcclusionBuffer::Polygon* out
+) {
+    for (int e = 0; e < 3; e++) {
+        GLuint p = t_indices[(e + 1) % 3];
+        GLuint q = t_indices[(e + 2) % 3];
+
+        int free_vertex = -1;
+        int shared = 0;
+        for (int k = 0; k < 3; k++) {
+            if (s_indices[k] == p || s_indices[k] == q) {
+                shared++;
+            } else {
+                free_vertex = k;
+            }
+        }
+
+        if (shared != 2 || free_vertex < 0) {
+            continue;
+        }
+
+        // r, p, d, q with r opposite the shared edge in t and d opposite it in s
+        OcclusionBuffer::Polygon quad;
+        int from[4] = { e, (e + 1) % 3, -1, (e + 2) % 3 };
+        for (int k = 0; k < 4; k++) {
+            const OcclusionBuffer::Polygon& source = from[k] < 0 ? s : t;
+            int v = from[k] < 0 ? free_vertex : from[k];
+
+            quad.x[k] = source.x[v];
+            quad.y[k] = source.y[v];
+            quad.z[k] = source.z[v];
+        }
+
+        quad.count = 4;
+
+        // convex when every corner turns the same way
+        float turns[4];
+        for (int k = 0; k < 4; k++) {
+            turns[k] = turn(quad.x, quad.y, k, (k + 1) % 4, (k + 2) % 4);
+        }
+
+        bool convex = (turns[0] > 0.0f && turns[1] > 0.0f && turns[2] > 0.0f && turns[3] > 0.0f)
+            || (turns[0] < 0.0f && turns[1] < 0.0f && turns[2] < 0.0f && turns[3] < 0.0f);
+
+        if (convex) {
+            *out = quad;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// depth plane z = a * x + b * y + c through three vertices of a polygon
+static bool depth_plane(const OcclusionBuffer::Polygon& polygon, int i0, int i1, int i2, float plane[3]) {
+    float dx1 = polygon.x[i1] - polygon.x[i0], dy1 = polygon.y[i1] - polygon.y[i0], dz1 = polygon.z[i1] - polygon.z[i0];
+    float dx2 = polygon.x[i2] - polygon.x[i0], dy2 = polygon.y[i2] - polygon.y[i0], dz2 = polygon.z[i2] - polygon.z[i0];
+
+    float nz = dx1 * dy2 - dy1 * dx2;
+    if (nz == 0.0f) {
+        return false;
+    }
+
+    plane[0] = -(dy1 * dz2 - dz1 * dy2) / nz;
+    plane[1] = -(dz1 * dx2 - dx1 * dz2) / nz;
+    plane[2] = polygon.z[i0] - plane[0] * polygon.x[i0] - plane[1] * polygon.y[i0];
+    return true;
+}
+
+void OcclusionBuffer::rasterize(int threads) {
+    std::fill(this->depth.begin(), this->depth.end(), 1.0f);
+    std::fill(this->tile_depth.begin(), this->tile_depth.end(), 1.0f);
+    this->polygons.clear();
+
+    // project every occluder into screen space
+    std::vector<glm::vec4> clip;
+    std::vector<Polygon> triangles;
+    std::vector<const GLuint*> triangle_indices;
+    std::vector<bool> merged;
+    std::unordered_map<nstd::U64, size_t> edges;
+
+    for (const Occluder& occluder : this->occluders) {
+        glm::mat4 m = this->view_projection * occluder.model;
+
+        clip.resize(occluder.vertex_count);
+        for (size_t v = 0; v < occluder.vertex_count; v++) {
+            const float* p = (const float*) (occluder.vertices + v * occluder.stride);
+            clip[v] = m * glm::vec4(p[0], p[1], p[2], 1.0f);
+        }
+
+        triangles.clear();
+        triangle_indices.clear();
+
+        for (size_t i = 0; i + 2 < occluder.index_count; i += 3) {
+            Polygon triangle;
+            triangle.count = 3;
+            bool valid = true;
+
+            for (int k = 0; k < 3 && valid; k++) {
+                GLuint index = occluder.indices[i + k];
+                const glm::vec4& c = clip[index < occluder.vertex_count ? index : 0];
+
+                // dropping an occluder triangle only hides less, so near plane crossings are skipped instead of clipped
+                valid = index < occluder.vertex_count && c.w >= this->min_w;
+                if (valid) {
+                    triangle.x[k] = (c.x / c.w * 0.5f + 0.5f) * (float) this->width;
+                    triangle.y[k] = (c.y / c.w * 0.5f + 0.5f) * (float) this->height;
+                    triangle.z[k] = std::min(std::max(c.z / c.w * 0.5f + 0.5f, 0.0f), 1.0f);
+
+                    // also false for nan
+                    valid = fabsf(triangle.x[k]) <= guard_band + (float) this->width && fabsf(triangle.y[k]) <= guard_band + (float) this->height;
+                }
+            }
+
+            if (valid) {
+                triangles.push_back(triangle);
+                triangle_indices.push_back(occluder.indices + i);
+            }
+        }
+
+        this->frame.occluder_triangles += (nstd::U32) triangles.size();
+
+        // pixels on an edge two triangles share are covered by neither alone, so pairs forming a convex quad go out as one
+        merged.assign(triangles.size(), false);
+        edges.clear();
+
+        for (size_t t = 0; t < triangles.size(); t++) {
+            const GLuint* indices = triangle_indices[t];
+
+            for (int e = 0; e < 3 && !merged[t]; e++) {
+                GLuint u = indices[(e + 1) % 3];
+                GLuint v = indices[(e + 2) % 3];
+                nstd::U64 key = (nstd::U64) std::min(u, v) << 32 | std::max(u, v);
+
+                auto it = edges.find(key);
+                if (it == edges.end()) {
+                    edges.emplace(key, t);
+                    continue;
+                }
+
+                size_t other = it->second;
+
+                Polygon quad;
+                if (!merged[other] && merge_quad(triangles[t], indices, triangles[other], triangle_indices[other], &quad)) {
+                    merged[t] = true;
+                    merged[other] = true;
+                    this->polygons.push_back(quad);
+                }
+            }
+        }
+
+        for (size_t t = 0; t < triangles.size(); t++) {
+            if (!merged[t]) {
+                this->polygons.push_back(triangles[t]);
+            }
+        }
+    }
+
+    // bands of whole tile rows, so each worker also owns the hierarchy of its rows
+    int workers = Parallel::worker_count(this->polygons.size(), min_parallel_polygons, threads);
+    Parallel::for_range(this->tiles_y, nstd::min((size_t) workers, (size_t) this->tiles_y), [this](int, size_t first, size_t last) {
+        rasterize_band((int) first, (int) last);
+    });
+}
+
+void OcclusionBuffer::rasterize_band(int first_tile_row, int last_tile_row) {
+    int band_y0 = first_tile_row * tile_size;
+    int band_y1 = last_tile_row * tile_size;
+
+    for (const Polygon& polygon : this->polygons) {
+        const float* xs = polygon.x;
+        const float* ys = polygon.y;
+        int count = polygon.count;
+
+        // edge functions are positive inside, flipped for clockwise polygons
+        float area = 0.0f;
+        for (int k = 0; k < count; k++) {
+            int next = (k + 1) % count;
+            area += xs[k] * ys[next] - xs[next] * ys[k];
+        }
+
+        if (area == 0.0f) {
+            continue;
+        }
+
+        float winding = area > 0.0f ? 1.0f : -1.0f;
+
+        // depth planes of both triangles of a quad, a triangle gets its one plane twice
+        float plane[2][3];
+        if (!depth_plane(polygon, 0, 1, count - 1, plane[0])) {
+            continue;
+        }
+
+        if (count == 3) {
+            memcpy(plane[1], plane[0], sizeof(plane[0]));
+        } else if (!depth_plane(polygon, 1, 2, 3, plane[1])) {
+            continue;
+        }
+
+        float x_min = xs[0], x_max = xs[0], y_min = ys[0], y_max = ys[0], z_max = polygon.z[0];
+        for (int k = 1; k < count; k++) {
+            x_min = std::min(x_min, xs[k]);
+            x_max = std::max(x_max, xs[k]);
+            y_min = std::min(y_min, ys[k]);
+            y_max = std::max(y_max, ys[k]);
+            z_max = std::max(z_max, polygon.z[k]);
+        }
+
+        // fully covered pixels lie within the bounds rounded inwards
+        int x0 = std::max((int) ceilf(clamp_bound(x_min, this->width)), 0);
+        int x1 = std::min((int) floorf(clamp_bound(x_max, this->width)) - 1, this->width - 1);
+        int y0 = std::max((int) ceilf(clamp_bound(y_min, this->height)), band_y0);
+        int y1 = std::min((int) floorf(clamp_bound(y_max, this->height)) - 1, std::min(band_y1, this->height) - 1);
+
+        if (x0 > x1 || y0 > y1) {
+            continue;
+        }
+
+        // edge k runs from vertex k to the next, e = a * x + b * y + c. a triangle's fourth edge is always inside
+        float a[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float b[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float c[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+        for (int k = 0; k < count; k++) {
+            int next = (k + 1) % count;
+
+            a[k] = (ys[k] - ys[next]) * winding;
+            b[k] = (xs[next] - xs[k]) * winding;
+            c[k] = -(a[k] * xs[k] + b[k] * ys[k]);
+        }
+
+        // an occluder may only hide what it fully covers, so a pixel is written when its worst corner
+        // is inside every edge and takes the depth of its farthest corner, never past the polygon
+        for (int k = 0; k < 4; k++) {
+            c[k] -= 0.5f * (fabsf(a[k]) + fabsf(b[k]));
+        }
+
+        for (int k = 0; k < 2; k++) {
+            plane[k][2] += 0.5f * (fabsf(plane[k][0]) + fabsf(plane[k][1]));
+        }
+
+        // rows start on a multiple of 4, the padded width keeps the last group in the row
+        int start = x0 & ~3;
+
+        for (int y = y0; y <= y1; y++) {
+            float py = (float) y + 0.5f;
+            float* row = this->depth.data() + (size_t) y * this->width;
+
+#ifdef OCCLUSION_SSE2
+            const __m128 centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            __m128 e_row[4], e_step[4];
+            for (int k = 0; k < 4; k++) {
+                e_row[k] = _mm_set1_ps(b[k] * py + c[k]);
+                e_step[k] = _mm_set1_ps(a[k]);
+            }
+
+            __m128 z_row[2], z_step[2];
+            for (int k = 0; k < 2; k++) {
+                z_row[k] = _mm_set1_ps(plane[k][1] * py + plane[k][2]);
+                z_step[k] = _mm_set1_ps(plane[k][0]);
+            }
+
+            __m128 z_limit = _mm_set1_ps(z_max);
+            __m128 zero = _mm_setzero_ps();
+
+            for (int x = start; x <= x1; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float) x), centers);
+
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(e_step[0], px), e_row[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(e_step[1], px), e_row[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(e_step[2], px), e_row[2]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(e_step[3], px), e_row[3]), zero));
+
+                if (_mm_movemask_ps(inside) == 0) {
+                    continue;
+                }
+
+                __m128 z = _mm_max_ps(
+                    _mm_add_ps(_mm_mul_ps(z_step[0], px), z_row[0]),
+                    _mm_add_ps(_mm_mul_ps(z_step[1], px), z_row[1])
+                );
+
+                __m128 old_depth = _mm_loadu_ps(row + x);
+                __m128 new_depth = _mm_min_ps(old_depth, _mm_min_ps(z, z_limit));
+
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, new_depth), _mm_andnot_ps(inside, old_depth)));
+            }
+#else
+            // same per row terms as the sse path so both round alike
+            float e_row[4], z_row[2];
+            for (int k = 0; k < 4; k++) {
+                e_row[k] = b[k] * py + c[k];
+            }
+
+            for (int k = 0; k < 2; k++) {
+                z_row[k] = plane[k][1] * py + plane[k][2];
+            }
+
+            for (int x = start; x <= x1; x++) {
+                float px = (float) x + 0.5f;
+
+                bool inside = a[0] * px + e_row[0] >= 0.0f
+                    && a[1] * px + e_row[1] >= 0.0f
+                    && a[2] * px + e_row[2] >= 0.0f
+                    && a[3] * px + e_row[3] >= 0.0f;
+
+                if (inside) {
+                    float z = std::max(plane[0][0] * px + z_row[0], plane[1][0] * px + z_row[1]);
+                    row[x] = std::min(row[x], std::min(z, z_max));
+                }
+            }
+#endif
+        }
+    }
+
+    // farthest depth of every tile in the band
+    for (int ty = first_tile_row; ty < last_tile_row; ty++) {
+        for (int tx = 0; tx < this->tiles_x; tx++) {
+            float farthest = 0.0f;
+
+            for (int y = ty * tile_size; y < (ty + 1) * tile_size; y++) {
+                const float* row = this->depth.data() + (size_t) y * this->width + tx * tile_size;
+                for (int x = 0; x < tile_size; x++) {
+                    farthest = std::max(farthest, row[x]);
+                }
+            }
+
+            this->tile_depth[(size_t) ty * this->tiles_x + tx] = farthest;
+        }
+    }
+}
+
+bool OcclusionBuffer::visible(const glm::vec3& bounds_min, const glm::vec3& bounds_max, const glm::mat4& model) const {
+    this->frame.tested++;
+
+    glm::mat4 m = this->view_projection * model;
+
+    float x_min = FLT_MAX, y_min = FLT_MAX, z_min = FLT_MAX;
+    float x_max = -FLT_MAX, y_max = -FLT_MAX;
+
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 p = m * glm::vec4(
+            (corner & 1) ? bounds_max.x : bounds_min.x,
+            (corner & 2) ? bounds_max.y : bounds_min.y,
+            (corner & 4) ? bounds_max.z : bounds_min.z,
+            1.0f
+        );
+
+        // written so nan counts as crossing too
+        if (!(p.w >= this->min_w)) {
+            return true;
+        }
+
+        float x = (p.x / p.w * 0.5f + 0.5f) * (float) this->width;
+        float y = (p.y / p.w * 0.5f + 0.5f) * (float) this->height;
+
+        if (!std::isfinite(x) || !std::isfinite(y)) {
+            return true;
+        }
+
+        x_min = std::min(x_min, x);
+        x_max = std::max(x_max, x);
+        y_min = std::min(y_min, y);
+        y_max = std::max(y_max, y);
+        z_min = std::min(z_min, p.z / p.w * 0.5f + 0.5f);
+    }
+
+    // every pixel the box touches, not just the covered centers
+    int x0 = std::max((int) floorf(clamp_bound(x_min, this->width)), 0);
+    int x1 = std::min((int) floorf(clamp_bound(x_max, this->width)), this->width - 1);
+    int y0 = std::max((int) floorf(clamp_bound(y_min, this->height)), 0);
+    int y1 = std::min((int) floorf(clamp_bound(y_max, this->height)), this->height - 1);
+
+    if (x0 > x1 || y0 > y1) {
+        this->frame.hidden++;
+        return false;
+    }
+
+    // tiles whose farthest depth is in front of the box hide it whole, the rest are checked per pixel
+    for (int ty = y0 / tile_size; ty <= y1 / tile_size; ty++) {
+        for (int tx = x0 / tile_size; tx <= x1 / tile_size; tx++) {
+            if (this->tile_depth[(size_t) ty * this->tiles_x + tx] < z_min) {
+                continue;
+            }
+
+            int py0 = std::max(y0, ty * tile_size), py1 = std::min(y1, (ty + 1) * tile_size - 1);
+            int px0 = std::max(x0, tx * tile_size), px1 = std::min(x1, (tx + 1) * tile_size - 1);
+
+            for (int y = py0; y <= py1; y++) {
+                const float* row = this->depth.data() + (size_t) y * this->width;
+                for (int x = px0; x <= px1; x++) {
+                    if (row[x] >= z_min) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    this->frame.hidden++;
+    return false;
+}
+
+void OcclusionBuffer::log_stats() const {
+    LOGI(
+        "occlusion: %u occluder triangles, %u of %u bounds hidden",
+        this->last_frame.occluder_triangles, this->last_frame.hidden, this->last_frame.tested
+    );
+}
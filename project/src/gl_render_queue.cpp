@@ -0,0 +1,75 @@
+#include "main.hpp"
+
+static constexpr nstd::U64 state_mask = (1ull << RenderQueue::state_bits) - 1;
+static constexpr nstd::U64 depth_mask = (1ull << RenderQueue::depth_bits) - 1;
+
+RenderQueue::RenderQueue() {
+    this->last_frame = {};
+}
+
+void RenderQueue::clear() {
+    this->items.clear();
+    this->keys.clear();
+}
+
+GLuint RenderQueue::vertex_array_of(const Mesh* mesh) {
+    return mesh->arena ? mesh->arena->VAO.id : mesh->VAO.id;
+}
+
+void RenderQueue::add(
+    Pass pass,
+    Mesh* mesh,
+    const ShaderProgram* shader,
+    const SceneObject* binding,
+    const Camera* camera,
+    int lod
+) {
+    // depth relative to the far plane, quantized to the key's depth bits
+    float distance = glm::length(binding->position - camera->object_binding->position);
+    float depth = std::min(std::max(distance / camera->far_plane, 0.0f), 1.0f);
+    nstd::U64 quantized = (nstd::U64) (depth * (float) depth_mask);
+
+    nstd::U64 state = ((nstd::U64) shader->id & state_mask) << state_bits
+        | ((nstd::U64) vertex_array_of(mesh) & state_mask);
+
+    // opaque draws group by state then go front to back, transparent ones have to blend back to front
+    nstd::U64 key = (nstd::U64) pass << (64 - pass_bits);
+    if (pass == QUEUE_PASS_TRANSPARENT) {
+        key |= (depth_mask - quantized) << (2 * state_bits) | state;
+    } else {
+        key |= state << depth_bits | quantized;
+    }
+
+    this->keys.push_back({ key, (nstd::U32) this->items.size() });
+    this->items.push_back({ mesh, shader, binding, lod });
+}
+
+void RenderQueue::submit() {
+    this->last_frame = {};
+    if (this->items.empty()) {
+        return;
+    }
+
+    this->scratch.resize(this->keys.size());
+    nstd::Sort::radix(this->keys.data(), this->keys.size(), this->scratch.data());
+
+    const Item* previous = nullptr;
+
+    for (const nstd::Sort::KeyIndex& key : this->keys) {
+        const Item& item = this->items[key.index];
+
+        if (!previous || item.shader != previous->shader) {
+            item.shader->activate();
+            this->last_frame.shader_changes++;
+        }
+
+        item.mesh->draw(item.shader, item.binding, item.lod);
+        this->last_frame.draws++;
+
+        previous = &item;
+    }
+}
+
+void RenderQueue::log_stats() const {
+    LOGI("render queue: %u draws, %u shader changes", this->last_frame.draws, this->last_frame.shader_changes);
+}
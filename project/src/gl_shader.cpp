@@ -1,9 +1,14 @@
 #include "main.hpp"
 
+bool ShaderProgram::parallel_compile = false;
+
 ShaderProgram::ShaderProgram() {
     this->num_shaders = 0;
     this->id = glCreateProgram();
     this->status = PRGM_UNLINKED;
+    this->pending_cache = nullptr;
+    this->pending_key = 0;
+    this->pending_polls = 0;
 }
 
 ShaderProgram::~ShaderProgram() {
@@ -12,13 +17,14 @@ ShaderProgram::~ShaderProgram() {
     }
 
     if (this->id) {
+        GLState::on_delete_program(this->id);
         glDeleteProgram(this->id);
     }
 }
 
-void ShaderProgram::add(const char* path) {
+void ShaderProgram::add(const char* path, const char* defines) {
     // check program state
-    if (this->status == PRGM_LINKED) {
+    if (this->status != PRGM_UNLINKED) {
         LOGE("add shader failed: bad state");
         return;
     }
@@ -31,71 +37,71 @@ void ShaderProgram::add(const char* path) {
 
     // get shader type
     GLint shader_type;
-    if (strstr(path, ".vert")) {
+    const char* ext = strrchr(path, '.');
+    if (ext && strcmp(ext, ".vert") == 0) {
         shader_type = GL_VERTEX_SHADER;
-    } else if (strstr(path, ".frag")) {
+    } else if (ext && strcmp(ext, ".frag") == 0) {
         shader_type = GL_FRAGMENT_SHADER;
+    } else if (ext && strcmp(ext, ".comp") == 0) {
+        shader_type = GL_COMPUTE_SHADER;
     } else {
         LOGE("failed to find shader type for %s", path);
         return;
     }
 
-    // get shader source
-    FILE* file = fopen(path, "rb+");
-    if (!file) {
-        LOGE("failed to open file %s", path);
+    // get shader source with includes and defines applied
+    std::vector<std::string> paths;
+    if (!ShaderSource::load(path, defines, &this->sources[this->num_shaders], &paths)) {
         return;
     }
 
-    // get file content
-    struct stat file_stats;
-    
-    if (fstat(fileno(file), &file_stats) != 0) {
-        LOGE("failed to get file stats: %s", path);
-        fclose(file);
-        return;
+    for (std::string& file : paths) {
+        if (std::find(this->files.begin(), this->files.end(), file) == this->files.end()) {
+            this->files.push_back(std::move(file));
+        }
     }
 
-    long fsize = file_stats.st_size;
-    char* buf = (char*) malloc(fsize);
+    LOGI("added shader %s", path);
+    this->shaders[this->num_shaders] = 0;
+    this->shader_types[this->num_shaders] = shader_type;
+    this->num_shaders++;
+}
 
-    if (!check_alloc(buf)) {
-        fclose(file);
-        return;
-    }
+nstd::U64 ShaderProgram::get_cache_key(const ShaderCache* cache) const {
+    nstd::U64 key = cache->base_key();
 
-    fread(buf, 1, fsize, file);
-    buf[fsize] = '\0';
-    fclose(file);
+    for (int i = 0; i < this->num_shaders; i++) {
+        key = ShaderCache::hash(key, &this->shader_types[i], sizeof(GLenum));
 
-    // add file content to shader
-    GLuint* shader_id = &this->shaders[this->num_shaders];
-    *shader_id = glCreateShader(shader_type);
-    glShaderSource(*shader_id, 1, &buf, nullptr);
+        for (const ShaderSource::Segment& segment : this->sources[i].segments) {
+            key = ShaderCache::hash(key, segment.data, segment.length);
+        }
+    }
 
-    free(buf);
+    return key;
+}
 
-    // compile shader
-    glCompileShader(*shader_id);
-    GLint ret;
-    glGetShaderiv(*shader_id, GL_COMPILE_STATUS,&ret);
-    if (!ret) {
-        char buf[512];
-        glGetShaderInfoLog(*shader_id, sizeof(buf), nullptr, buf);
-        LOGE("failed to compile shader %s", buf);
-        glDeleteShader(*shader_id);
-        *shader_id = 0;
-        return;
+void ShaderProgram::init_parallel_compile() {
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        // 0xFFFFFFFF lets the driver pick its thread count
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        parallel_compile = true;
+    } else if (GLAD_GL_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        parallel_compile = true;
     }
 
-    LOGI("added shader %s", path);
-    glAttachShader(this->id, *shader_id);        
-    this->num_shaders++;
+    LOGI("parallel shader compile %s", parallel_compile ? "enabled" : "unavailable");
+}
+
+void ShaderProgram::link(const ShaderCache* cache) {
+    submit(cache);
+    finish();
 }
 
-void ShaderProgram::link() {
+void ShaderProgram::submit(const ShaderCache* cache) {
     // check program state
-    if (this->status == PRGM_LINKED) {
+    if (this->status != PRGM_UNLINKED) {
         LOGE("link program failed: bad state");
         return;
     }
@@ -105,26 +111,153 @@ void ShaderProgram::link() {
         return;
     }
 
+    this->pending_cache = cache;
+    this->pending_key = 0;
+
+    if (cache) {
+        this->pending_key = get_cache_key(cache);
+
+        if (cache->load(this->id, this->pending_key)) {
+            LOGI("loaded shader program %016llx from cache", (unsigned long long) this->pending_key);
+            release_sources();
+            this->uniform_locations.clear();
+            this->pending_cache = nullptr;
+            this->status = PRGM_LINKED;
+            return;
+        }
+    }
+
+    // compile stages, status is only queried once the link is done
+    for (int i = 0; i < this->num_shaders; i++) {
+        GLuint* shader_id = &this->shaders[i];
+
+        if (!*shader_id) {
+            const std::vector<ShaderSource::Segment>& segments = this->sources[i].segments;
+
+            // segments point straight into the mapped files, gl copies them on glShaderSource
+            std::vector<const GLchar*> strings(segments.size());
+            std::vector<GLint> lengths(segments.size());
+
+            for (size_t s = 0; s < segments.size(); s++) {
+                strings[s] = segments[s].data;
+                lengths[s] = segments[s].length;
+            }
+
+            *shader_id = glCreateShader(this->shader_types[i]);
+            glShaderSource(*shader_id, (GLsizei) segments.size(), strings.data(), lengths.data());
+            glCompileShader(*shader_id);
+            glAttachShader(this->id, *shader_id);
+        }
+    }
+
+    release_sources();
+
+    if (cache) {
+        glProgramParameteri(this->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(this->id);
+    this->pending_polls = 0;
+    this->status = PRGM_PENDING;
+}
+
+void ShaderProgram::release_sources() {
+    for (int i = 0; i < this->num_shaders; i++) {
+        this->sources[i].clear();
+    }
+}
+
+bool ShaderProgram::poll() {
+    if (this->status != PRGM_PENDING) {
+        return this->status == PRGM_LINKED;
+    }
+
+    // without the extension there is no way to ask, give the driver a few frames before waiting on it
+    if (!parallel_compile) {
+        return ++this->pending_polls > blind_polls && finish();
+    }
+
+    GLint done = GL_FALSE;
+    glGetProgramiv(this->id, GL_COMPLETION_STATUS_KHR, &done);
+
+    if (!done) {
+        return false;
+    }
+
+    return finish();
+}
+
+bool ShaderProgram::finish() {
+    if (this->status != PRGM_PENDING) {
+        return this->status == PRGM_LINKED;
+    }
+
     GLint ret;
     glGetProgramiv(this->id, GL_LINK_STATUS, &ret);
     if (!ret) {
         char buf[512];
+
+        // report the stage that failed to compile before the link error
+        for (int i = 0; i < this->num_shaders; i++) {
+            glGetShaderiv(this->shaders[i], GL_COMPILE_STATUS, &ret);
+            if (!ret) {
+                glGetShaderInfoLog(this->shaders[i], sizeof(buf), nullptr, buf);
+                LOGE("failed to compile shader %s", buf);
+            }
+        }
+
         glGetProgramInfoLog(this->id, sizeof(buf), nullptr, buf);
         LOGE("failed to link shader program %s", buf);
-        return;
+        this->status = PRGM_FAILED;
+        return false;
     }
 
+    if (this->pending_cache) {
+        this->pending_cache->store(this->id, this->pending_key);
+        this->pending_cache = nullptr;
+    }
+
+    this->uniform_locations.clear();
     this->status = PRGM_LINKED;
+    return true;
+}
+
+bool ShaderProgram::ready() const {
+    return this->status == PRGM_LINKED;
+}
+
+void ShaderProgram::swap(ShaderProgram* other) {
+    std::swap(this->id, other->id);
+    std::swap(this->shaders, other->shaders);
+    std::swap(this->shader_types, other->shader_types);
+    std::swap(this->sources, other->sources);
+    std::swap(this->files, other->files);
+    std::swap(this->num_shaders, other->num_shaders);
+    std::swap(this->status, other->status);
+    std::swap(this->pending_cache, other->pending_cache);
+    std::swap(this->pending_key, other->pending_key);
+    std::swap(this->pending_polls, other->pending_polls);
+    std::swap(this->uniform_locations, other->uniform_locations);
 }
 
 void ShaderProgram::activate() const {
-    if (this->status == PRGM_UNLINKED) {
+    if (this->status != PRGM_LINKED) {
         LOGE("run program failed: bad state");
         return;
     }
 
-    glUseProgram(this->id);
+    GLState::use_program(this->id);
+}
+
+GLint ShaderProgram::get_uniform_location(nstd::U32 name) const {
+    auto it = this->uniform_locations.find(name);
+    if (it != this->uniform_locations.end()) {
+        return it->second;
+    }
+
+    GLint location = glGetUniformLocation(this->id, nstd::StringTable::str(name));
+    this->uniform_locations[name] = location;
+    return location;
 }
 
 /*
@@ -132,27 +265,45 @@ void ShaderProgram::activate() const {
 */
 
 void ShaderProgram::set_uniform_1i(const char* name, const GLint data) const {
-    GLuint uniID = glGetUniformLocation(this->id, name);
-    glUniform1i(uniID, data);
+    set_uniform_1i(nstd::StringTable::intern(name), data);
 }
 
 void ShaderProgram::set_uniform_1f(const char* name, const GLfloat data) const {
-    GLuint uniID = glGetUniformLocation(this->id, name);
-    glUniform1f(uniID, data);
+    set_uniform_1f(nstd::StringTable::intern(name), data);
 }
 
 void ShaderProgram::set_uniform_3fv(const char* name, const GLfloat* data) const {
-    GLuint uniID = glGetUniformLocation(this->id, name);
-    glUniform3fv(uniID, 1, data);
+    set_uniform_3fv(nstd::StringTable::intern(name), data);
 }
 
 void ShaderProgram::set_uniform_4fv(const char* name, const GLfloat* data) const {
-    GLuint uniID = glGetUniformLocation(this->id, name);
-    glUniform4fv(uniID, 1, data);
+    set_uniform_4fv(nstd::StringTable::intern(name), data);
 }
 
 void ShaderProgram::set_uniform_matrix_4fv(const char* name, const GLfloat* data) const {
-    GLuint uniID = glGetUniformLocation(this->id, name);
-    glUniformMatrix4fv(uniID, 1, GL_FALSE, data);
+    set_uniform_matrix_4fv(nstd::StringTable::intern(name), data);
+}
+
+/*
+    setting uniforms by interned name
+*/
+
+void ShaderProgram::set_uniform_1i(nstd::U32 name, const GLint data) const {
+    glUniform1i(get_uniform_location(name), data);
 }
 
+void ShaderProgram::set_uniform_1f(nstd::U32 name, const GLfloat data) const {
+    glUniform1f(get_uniform_location(name), data);
+}
+
+void ShaderProgram::set_uniform_3fv(nstd::U32 name, const GLfloat* data) const {
+    glUniform3fv(get_uniform_location(name), 1, data);
+}
+
+void ShaderProgram::set_uniform_4fv(nstd::U32 name, const GLfloat* data) const {
+    glUniform4fv(get_uniform_location(name), 1, data);
+}
+
+void ShaderProgram::set_uniform_matrix_4fv(nstd::U32 name, const GLfloat* data) const {
+    glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, data);
+}
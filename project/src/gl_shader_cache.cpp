@@ -0,0 +1,162 @@
+#include "main.hpp"
+
+#ifdef _WIN32
+#   include <direct.h>
+#   define make_dir(path) _mkdir(path)
+#else
+#   define make_dir(path) mkdir(path, 0755)
+#endif
+
+ShaderCache::ShaderCache(const char* dir) {
+    snprintf(this->dir, sizeof(this->dir), "%s", dir);
+    this->driver_hash = 0;
+    this->enabled = false;
+}
+
+ShaderCache::~ShaderCache() {}
+
+void ShaderCache::init() {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+    if (formats == 0) {
+        LOGI("shader cache disabled: driver exposes no program binary formats");
+        return;
+    }
+
+    // binaries are only valid for the driver build that produced them
+    const GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+
+    nstd::U64 key = 14695981039346656037ull;
+    for (GLenum name : driver_strings) {
+        const char* str = (const char*) glGetString(name);
+
+        if (str) {
+            key = hash(key, str, strlen(str));
+        }
+    }
+
+    make_dir(this->dir);
+
+    this->driver_hash = key;
+    this->enabled = true;
+}
+
+nstd::U64 ShaderCache::hash(nstd::U64 key, const void* bytes, size_t len) {
+    const nstd::U8* data = (const nstd::U8*) bytes;
+
+    nstd::U64 h = ((nstd::U64) nstd::Hash::generate(data, len, nstd::Hash::fnv1a) << 32)
+        | nstd::Hash::generate(data, len, nstd::Hash::djb2);
+
+    return (key ^ h) * 1099511628211ull;
+}
+
+nstd::U64 ShaderCache::base_key() const {
+    return this->driver_hash;
+}
+
+void ShaderCache::get_path(nstd::U64 key, char* buf, size_t len) const {
+    snprintf(buf, len, "%s/%016llx.bin", this->dir, (unsigned long long) key);
+}
+
+bool ShaderCache::load(GLuint program, nstd::U64 key) const {
+    if (!this->enabled) {
+        return false;
+    }
+
+    char path[320];
+    get_path(key, path, sizeof(path));
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+
+    FileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1
+        || header.magic != file_magic
+        || header.version != file_version
+        || header.key != key
+        || header.length <= 0
+    ) {
+        LOGE("discarding malformed shader cache entry %s", path);
+        fclose(file);
+        remove(path);
+        return false;
+    }
+
+    void* binary = malloc(header.length);
+    if (!check_alloc(binary)) {
+        fclose(file);
+        return false;
+    }
+
+    bool read = fread(binary, 1, header.length, file) == (size_t) header.length;
+    fclose(file);
+
+    if (!read) {
+        LOGE("discarding truncated shader cache entry %s", path);
+        free(binary);
+        remove(path);
+        return false;
+    }
+
+    glProgramBinary(program, header.format, binary, header.length);
+    free(binary);
+
+    // drivers may reject binaries after an update even with a matching version string
+    GLint ret;
+    glGetProgramiv(program, GL_LINK_STATUS, &ret);
+    if (!ret) {
+        LOGI("shader cache entry rejected by driver %s", path);
+        remove(path);
+        return false;
+    }
+
+    return true;
+}
+
+void ShaderCache::store(GLuint program, nstd::U64 key) const {
+    if (!this->enabled) {
+        return;
+    }
+
+    FileHeader header;
+    header.magic = file_magic;
+    header.version = file_version;
+    header.key = key;
+    header.length = 0;
+
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &header.length);
+    if (header.length <= 0) {
+        return;
+    }
+
+    void* binary = malloc(header.length);
+    if (!check_alloc(binary)) {
+        return;
+    }
+
+    glGetProgramBinary(program, header.length, &header.length, &header.format, binary);
+
+    char path[320];
+    get_path(key, path, sizeof(path));
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        LOGE("failed to open shader cache entry %s", path);
+        free(binary);
+        return;
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(binary, 1, header.length, file) == (size_t) header.length;
+
+    fclose(file);
+    free(binary);
+
+    if (!written) {
+        LOGE("failed to write shader cache entry %s", path);
+        remove(path);
+    }
+}
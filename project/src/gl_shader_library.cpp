@@ -0,0 +1,232 @@
+#include "main.hpp"
+
+ShaderLibrary::ShaderLibrary(const ShaderCache* cache) {
+    this->num_stages = 0;
+    this->num_options = 0;
+    this->bits_used = 0;
+    this->cache = cache;
+    this->watcher = nullptr;
+}
+
+ShaderLibrary::~ShaderLibrary() {
+    for (auto& [mask, program] : this->variants) {
+        delete program;
+    }
+
+    for (auto& [mask, reload] : this->reloads) {
+        delete reload.program;
+    }
+
+    this->variants.clear();
+    this->reloads.clear();
+}
+
+void ShaderLibrary::add_stage(const char* path) {
+    if (this->num_stages >= ShaderProgram::max_shaders) {
+        LOGE("shader library reached max stages");
+        return;
+    }
+
+    this->stages[this->num_stages++] = path;
+}
+
+int ShaderLibrary::add_option(const char* name, int bits, nstd::U32 max_value) {
+    if (this->num_options >= max_options || this->bits_used + bits > 32) {
+        THROW("shader library out of permutation bits");
+    }
+
+    Option* option = &this->options[this->num_options];
+    option->name = name;
+    option->shift = this->bits_used;
+    option->bits = bits;
+
+    nstd::U32 bit_limit = (nstd::U32) ((1ull << bits) - 1);
+    option->max_value = (max_value && max_value < bit_limit) ? max_value : bit_limit;
+
+    this->bits_used += bits;
+    return this->num_options++;
+}
+
+nstd::U32 ShaderLibrary::option_bits(int option, nstd::U32 value) const {
+    const Option* opt = &this->options[option];
+
+    if (value > opt->max_value) {
+        LOGE("shader option %s value %u out of range", opt->name, value);
+        value = opt->max_value;
+    }
+
+    return value << opt->shift;
+}
+
+void ShaderLibrary::get_defines(nstd::U32 mask, std::string* out) const {
+    out->clear();
+
+    for (int i = 0; i < this->num_options; i++) {
+        const Option* opt = &this->options[i];
+        nstd::U32 value = (mask >> opt->shift) & (nstd::U32) ((1ull << opt->bits) - 1);
+
+        // a zero value leaves the option undefined so the shader takes its generic path
+        if (!value) {
+            continue;
+        }
+
+        out->append("#define ");
+        out->append(opt->name);
+
+        if (opt->bits > 1) {
+            out->append(" " + std::to_string(value));
+        }
+
+        out->push_back('\n');
+    }
+}
+
+ShaderProgram* ShaderLibrary::build(nstd::U32 mask) {
+    std::string defines;
+    get_defines(mask, &defines);
+
+    ShaderProgram* program = new ShaderProgram();
+    for (int i = 0; i < this->num_stages; i++) {
+        program->add(this->stages[i], defines.c_str());
+    }
+
+    // a stage that failed to load would otherwise link into a different program
+    if (program->num_shaders != this->num_stages) {
+        program->status = ShaderProgram::PRGM_FAILED;
+        watch_files(program);
+        return program;
+    }
+
+    // includes are only known once the sources are loaded, they can differ per variant
+    watch_files(program);
+    program->submit(this->cache);
+    return program;
+}
+
+ShaderProgram* ShaderLibrary::request(nstd::U32 mask) {
+    auto it = this->variants.find(mask);
+    if (it != this->variants.end()) {
+        return it->second;
+    }
+
+    // failed variants are kept too so they are not rebuilt every frame
+    ShaderProgram* program = build(mask);
+    this->variants[mask] = program;
+    return program;
+}
+
+ShaderProgram* ShaderLibrary::get(nstd::U32 mask) {
+    ShaderProgram* program = request(mask);
+
+    if (program->status == ShaderProgram::PRGM_PENDING && !program->finish()) {
+        LOGE("failed to build shader variant %08x", mask);
+    }
+
+    return program;
+}
+
+ShaderProgram* ShaderLibrary::get_ready(nstd::U32 mask, ShaderProgram* fallback) {
+    ShaderProgram* program = request(mask);
+    return program->poll() ? program : fallback;
+}
+
+int ShaderLibrary::poll() {
+    int pending = 0;
+
+    for (auto& [mask, program] : this->variants) {
+        if (program->status != ShaderProgram::PRGM_PENDING) {
+            continue;
+        }
+
+        program->poll();
+
+        if (program->status == ShaderProgram::PRGM_PENDING) {
+            pending++;
+        } else if (program->status == ShaderProgram::PRGM_FAILED) {
+            LOGE("failed to build shader variant %08x", mask);
+        }
+    }
+
+    for (auto it = this->reloads.begin(); it != this->reloads.end();) {
+        Reload* reload = &it->second;
+
+        // give the driver a frame before asking, without parallel compile the ask blocks
+        if (reload->fresh) {
+            reload->fresh = false;
+            pending++;
+            ++it;
+            continue;
+        }
+
+        if (!reload->program->poll() && reload->program->status == ShaderProgram::PRGM_PENDING) {
+            pending++;
+            ++it;
+            continue;
+        }
+
+        if (reload->program->status == ShaderProgram::PRGM_LINKED) {
+            LOGI("reloaded shader variant %08x", it->first);
+            this->variants[it->first]->swap(reload->program);
+        } else {
+            LOGE("failed to reload shader variant %08x, keeping the old program", it->first);
+        }
+
+        // after a swap this holds the old gl objects
+        delete reload->program;
+        it = this->reloads.erase(it);
+    }
+
+    return pending;
+}
+
+bool ShaderLibrary::depends_on(const std::string& path) const {
+    for (int i = 0; i < this->num_stages; i++) {
+        if (path == this->stages[i]) {
+            return true;
+        }
+    }
+
+    for (auto& [mask, program] : this->variants) {
+        if (std::find(program->files.begin(), program->files.end(), path) != program->files.end()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ShaderLibrary::watch(ShaderWatcher* watcher) {
+    this->watcher = watcher;
+
+    // stages are watched even before a variant is built from them, a stage that failed to
+    // load has no files yet and is picked up once it is fixed
+    for (int i = 0; i < this->num_stages; i++) {
+        watcher->watch(this->stages[i]);
+    }
+
+    for (auto& [mask, program] : this->variants) {
+        watch_files(program);
+    }
+}
+
+void ShaderLibrary::watch_files(const ShaderProgram* program) const {
+    if (!this->watcher) {
+        return;
+    }
+
+    for (const std::string& file : program->files) {
+        this->watcher->watch(file);
+    }
+}
+
+void ShaderLibrary::reload() {
+    for (auto& [mask, program] : this->variants) {
+        // a newer edit replaces a reload still in flight
+        auto it = this->reloads.find(mask);
+        if (it != this->reloads.end()) {
+            delete it->second.program;
+        }
+
+        this->reloads[mask] = { build(mask), true };
+    }
+}
@@ -0,0 +1,309 @@
+#include "main.hpp"
+
+std::mutex ShaderSource::lock;
+std::unordered_map<std::string, ShaderSource::File> ShaderSource::files;
+std::vector<MappedFile*> ShaderSource::packs;
+
+/*
+    expanded source
+*/
+
+void ShaderSource::Expanded::add(const char* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    this->segments.push_back({ data, (GLint) length });
+}
+
+void ShaderSource::Expanded::add_generated(std::string text, bool front) {
+    // deque keeps element addresses stable so earlier segments stay valid
+    this->generated.push_back(std::move(text));
+    const std::string& owned = this->generated.back();
+
+    Segment segment = { owned.data(), (GLint) owned.size() };
+
+    if (front) {
+        this->segments.insert(this->segments.begin(), segment);
+    } else {
+        this->segments.push_back(segment);
+    }
+}
+
+size_t ShaderSource::Expanded::length() const {
+    size_t len = 0;
+
+    for (const Segment& segment : this->segments) {
+        len += segment.length;
+    }
+
+    return len;
+}
+
+void ShaderSource::Expanded::clear() {
+    this->segments.clear();
+    this->generated.clear();
+}
+
+/*
+    source cache
+*/
+
+const ShaderSource::File* ShaderSource::open(const char* path) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto it = files.find(path);
+    if (it != files.end()) {
+        return &it->second;
+    }
+
+    MappedFile* mapping = new MappedFile();
+    if (!mapping->open(path)) {
+        delete mapping;
+        return nullptr;
+    }
+
+    File* file = &files[path];
+    file->mapping = mapping;
+    file->data = mapping->data;
+    file->size = mapping->size;
+
+    return file;
+}
+
+bool ShaderSource::mount_pack(const char* path) {
+    struct stat file_stats;
+    if (stat(path, &file_stats) != 0) {
+        LOGI("no shader pack at %s, using loose files", path);
+        return false;
+    }
+
+    MappedFile* pack = new MappedFile();
+    if (!pack->open(path)) {
+        delete pack;
+        return false;
+    }
+
+    const PackHeader* header = (const PackHeader*) pack->data;
+
+    if (
+        pack->size < sizeof(PackHeader) || 
+        header->magic != pack_magic || 
+        header->version != pack_version ||
+        pack->size < sizeof(PackHeader) + header->count * sizeof(PackEntry)
+    ) {
+        LOGE("invalid shader pack %s", path);
+        delete pack;
+        return false;
+    }
+
+    const PackEntry* entries = (const PackEntry*) (pack->data + sizeof(PackHeader));
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (nstd::U32 i = 0; i < header->count; i++) {
+        const PackEntry* entry = &entries[i];
+
+        if (entry->offset + entry->size > pack->size) {
+            LOGE("shader pack entry %.*s out of range", pack_path_len, entry->path);
+            continue;
+        }
+
+        std::string entry_path(entry->path, strnlen(entry->path, pack_path_len));
+        files.emplace(entry_path, File { nullptr, pack->data + entry->offset, (size_t) entry->size });
+    }
+
+    packs.push_back(pack);
+    LOGI("mounted shader pack %s with %u files", path, header->count);
+    return true;
+}
+
+bool ShaderSource::write_pack(const char* pack_path, const char* const* paths, int count) {
+    std::vector<PackEntry> entries(count);
+    std::vector<MappedFile> sources(count);
+
+    nstd::U64 offset = sizeof(PackHeader) + count * sizeof(PackEntry);
+
+    for (int i = 0; i < count; i++) {
+        if (strlen(paths[i]) >= pack_path_len) {
+            LOGE("shader pack path too long: %s", paths[i]);
+            return false;
+        }
+
+        if (!sources[i].open(paths[i])) {
+            return false;
+        }
+
+        memset(&entries[i], 0, sizeof(PackEntry));
+        strcpy(entries[i].path, paths[i]);
+        entries[i].offset = offset;
+        entries[i].size = sources[i].size;
+
+        offset += sources[i].size;
+    }
+
+    FILE* file = fopen(pack_path, "wb");
+    if (!file) {
+        LOGE("failed to open file %s", pack_path);
+        return false;
+    }
+
+    PackHeader header = { pack_magic, pack_version, (nstd::U32) count, 0 };
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(entries.data(), sizeof(PackEntry), count, file) == (size_t) count;
+
+    for (int i = 0; ok && i < count; i++) {
+        ok = fwrite(sources[i].data, 1, sources[i].size, file) == sources[i].size;
+    }
+
+    fclose(file);
+
+    if (!ok) {
+        LOGE("failed to write shader pack %s", pack_path);
+        remove(pack_path);
+    }
+
+    return ok;
+}
+
+void ShaderSource::invalidate(const char* path) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto it = files.find(path);
+    if (it == files.end()) {
+        return;
+    }
+
+    // pack entries are dropped too so an edited loose file wins over the pack
+    delete it->second.mapping;
+    files.erase(it);
+}
+
+void ShaderSource::release() {
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (auto& [path, file] : files) {
+        delete file.mapping;
+    }
+
+    for (MappedFile* pack : packs) {
+        delete pack;
+    }
+
+    files.clear();
+    packs.clear();
+}
+
+/*
+    preprocessing
+*/
+
+// splices a file into out, each file is included once per stage
+bool ShaderSource::expand(const char* path, const char** defines, int depth, std::vector<std::string>* included, Expanded* out) {
+    if (depth > max_include_depth) {
+        LOGE("shader include depth exceeded at %s", path);
+        return false;
+    }
+
+    const File* file = open(path);
+    if (!file) {
+        return false;
+    }
+
+    // source string number used in #line so compile errors point at the right file
+    int file_idx = (int) included->size();
+    included->push_back(path);
+
+    std::string dir(path);
+    size_t slash = dir.find_last_of("/\\");
+    dir = (slash == std::string::npos) ? "" : dir.substr(0, slash + 1);
+
+    const char* data = file->data;
+    size_t size = file->size;
+
+    // lines without directives are handed out as runs pointing into the file
+    size_t run_start = 0;
+    size_t pos = 0;
+    int line_num = 0;
+
+    while (pos < size) {
+        const char* newline = (const char*) memchr(data + pos, '\n', size - pos);
+        size_t end = newline ? newline - data : size;
+        size_t next = newline ? end + 1 : size;
+
+        const char* line = data + pos;
+        size_t len = end - pos;
+        line_num++;
+
+        // skip leading whitespace to find directives
+        size_t i = 0;
+        while (i < len && (line[i] == ' ' || line[i] == '\t')) {
+            i++;
+        }
+
+        if (len - i >= 8 && strncmp(line + i, "#include", 8) == 0) {
+            const char* quote_open = (const char*) memchr(line + i, '"', len - i);
+            const char* quote_close = quote_open 
+                ? (const char*) memchr(quote_open + 1, '"', line + len - quote_open - 1) 
+                : nullptr;
+
+            if (!quote_close) {
+                LOGE("malformed include in %s:%i", path, line_num);
+                return false;
+            }
+
+            out->add(data + run_start, pos - run_start);
+            run_start = next;
+
+            std::string include_path = dir + std::string(quote_open + 1, quote_close - quote_open - 1);
+
+            if (std::find(included->begin(), included->end(), include_path) == included->end()) {
+                out->add_generated("#line 1 " + std::to_string(included->size()) + "\n");
+
+                if (!expand(include_path.c_str(), nullptr, depth + 1, included, out)) {
+                    return false;
+                }
+
+                out->add_generated("\n#line " + std::to_string(line_num + 1) + " " + std::to_string(file_idx) + "\n");
+            }
+        } else if (defines && *defines && len - i >= 8 && strncmp(line + i, "#version", 8) == 0) {
+            // #version has to stay the first statement, defines go right after it
+            out->add(data + run_start, next - run_start);
+            run_start = next;
+
+            std::string block = newline ? "" : "\n";
+            block += *defines;
+            block += "#line " + std::to_string(line_num + 1) + " " + std::to_string(file_idx) + "\n";
+            out->add_generated(std::move(block));
+
+            *defines = nullptr;
+        }
+
+        pos = next;
+    }
+
+    out->add(data + run_start, size - run_start);
+    return true;
+}
+
+bool ShaderSource::load(const char* path, const char* defines, Expanded* out, std::vector<std::string>* paths) {
+    std::vector<std::string> included;
+    out->clear();
+
+    if (!expand(path, &defines, 0, &included, out)) {
+        out->clear();
+        return false;
+    }
+
+    // no #version line, defines go in front
+    if (defines && *defines) {
+        out->add_generated(std::string(defines) + "#line 1 0\n", true);
+    }
+
+    if (paths) {
+        *paths = std::move(included);
+    }
+
+    return true;
+}
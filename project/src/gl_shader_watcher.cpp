@@ -0,0 +1,43 @@
+#include "main.hpp"
+
+ShaderWatcher::ShaderWatcher(double interval) {
+    this->interval = interval;
+    this->last_poll = 0.0;
+}
+
+void ShaderWatcher::watch(const std::string& path) {
+    for (const WatchedFile& file : this->files) {
+        if (file.path == path) {
+            return;
+        }
+    }
+
+    WatchedFile file = { path, {} };
+    FileStamp::get(path.c_str(), &file.stamp);
+    this->files.push_back(file);
+}
+
+bool ShaderWatcher::poll(double time, std::vector<std::string>* changed) {
+    changed->clear();
+
+    if (time - this->last_poll < this->interval) {
+        return false;
+    }
+
+    this->last_poll = time;
+
+    for (WatchedFile& file : this->files) {
+        FileStamp stamp;
+
+        // editors often truncate before writing, a missing file is picked up on the next poll.
+        // the size is compared too, two saves within the time resolution still differ in it
+        if (!FileStamp::get(file.path.c_str(), &stamp) || stamp == file.stamp) {
+            continue;
+        }
+
+        file.stamp = stamp;
+        changed->push_back(file.path);
+    }
+
+    return !changed->empty();
+}
@@ -0,0 +1,184 @@
+#include "main.hpp"
+
+GLuint GLState::program = GLState::unknown;
+GLuint GLState::vertex_array = GLState::unknown;
+GLuint GLState::array_buffer = GLState::unknown;
+GLuint GLState::element_buffer = GLState::unknown;
+GLuint GLState::uniform_buffer = GLState::unknown;
+GLuint GLState::storage_buffer = GLState::unknown;
+GLuint GLState::indirect_buffer = GLState::unknown;
+GLenum GLState::active_unit = GLState::unknown;
+GLuint GLState::textures[GLState::max_texture_units];
+
+GLState::Counters GLState::frame = { };
+GLState::Counters GLState::last_frame = { };
+
+void GLState::reset() {
+    program = unknown;
+    vertex_array = unknown;
+    array_buffer = unknown;
+    element_buffer = unknown;
+    uniform_buffer = unknown;
+    storage_buffer = unknown;
+    indirect_buffer = unknown;
+    active_unit = unknown;
+
+    for (int i = 0; i < max_texture_units; i++) {
+        textures[i] = unknown;
+    }
+}
+
+void GLState::begin_frame() {
+    last_frame = frame;
+    frame = { };
+}
+
+void GLState::log_last_frame() {
+    for (int i = 0; i < GLCALL_MAX; i++) {
+        LOGI("%-18s issued %6u skipped %6u", call_str[i], last_frame.issued[i], last_frame.skipped[i]);
+    }
+}
+
+// returns true when the call has to be issued, and records it
+bool GLState::filter(CallType type, GLuint* shadow, GLuint value) {
+    if (*shadow == value) {
+        frame.skipped[type]++;
+        return false;
+    }
+
+    *shadow = value;
+    frame.issued[type]++;
+    return true;
+}
+
+GLuint* GLState::get_buffer_binding(GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER: return &array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER: return &element_buffer;
+        case GL_UNIFORM_BUFFER: return &uniform_buffer;
+        case GL_SHADER_STORAGE_BUFFER: return &storage_buffer;
+        case GL_DRAW_INDIRECT_BUFFER: return &indirect_buffer;
+        default: return nullptr;
+    }
+}
+
+void GLState::use_program(GLuint id) {
+    if (filter(GLCALL_USE_PROGRAM, &program, id)) {
+        glUseProgram(id);
+    }
+}
+
+void GLState::bind_vertex_array(GLuint id) {
+    if (filter(GLCALL_BIND_VERTEX_ARRAY, &vertex_array, id)) {
+        glBindVertexArray(id);
+
+        // the element buffer binding belongs to the vertex array
+        element_buffer = unknown;
+    }
+}
+
+void GLState::bind_buffer(GLenum target, GLuint id) {
+    GLuint* shadow = get_buffer_binding(target);
+
+    if (!shadow) {
+        frame.issued[GLCALL_BIND_BUFFER]++;
+        glBindBuffer(target, id);
+        return;
+    }
+
+    if (filter(GLCALL_BIND_BUFFER, shadow, id)) {
+        glBindBuffer(target, id);
+    }
+}
+
+void GLState::bind_buffer_base(GLenum target, GLuint index, GLuint id) {
+    GLuint* shadow = get_buffer_binding(target);
+
+    if (shadow) {
+        *shadow = id;
+    }
+
+    frame.issued[GLCALL_BIND_BUFFER]++;
+    glBindBufferBase(target, index, id);
+}
+
+void GLState::bind_buffer_range(GLenum target, GLuint index, GLuint id, size_t offset, size_t size) {
+    GLuint* shadow = get_buffer_binding(target);
+
+    if (shadow) {
+        *shadow = id;
+    }
+
+    frame.issued[GLCALL_BIND_BUFFER]++;
+    glBindBufferRange(target, index, id, offset, size);
+}
+
+void GLState::active_texture(GLenum unit) {
+    if (filter(GLCALL_ACTIVE_TEXTURE, &active_unit, unit)) {
+        glActiveTexture(unit);
+    }
+}
+
+void GLState::bind_texture(GLenum unit, GLuint id) {
+    int idx = unit - GL_TEXTURE0;
+
+    if (idx < 0 || idx >= max_texture_units) {
+        active_texture(unit);
+        frame.issued[GLCALL_BIND_TEXTURE]++;
+        glBindTexture(GL_TEXTURE_2D, id);
+        return;
+    }
+
+    if (textures[idx] == id) {
+        frame.skipped[GLCALL_BIND_TEXTURE]++;
+        return;
+    }
+
+    active_texture(unit);
+    filter(GLCALL_BIND_TEXTURE, &textures[idx], id);
+    glBindTexture(GL_TEXTURE_2D, id);
+}
+
+void GLState::bind_texture(GLuint id) {
+    if (active_unit == unknown) {
+        active_texture(GL_TEXTURE0);
+    }
+
+    bind_texture(active_unit, id);
+}
+
+/*
+    deletion
+*/
+
+void GLState::on_delete_program(GLuint id) {
+    // a deleted program stays in use until replaced, but its name can be handed out again
+    if (program == id) {
+        program = unknown;
+    }
+}
+
+void GLState::on_delete_vertex_array(GLuint id) {
+    if (vertex_array == id) {
+        vertex_array = 0;
+        element_buffer = unknown;
+    }
+}
+
+void GLState::on_delete_buffer(GLuint id) {
+    GLuint* bindings[] = { &array_buffer, &uniform_buffer, &storage_buffer, &indirect_buffer, &element_buffer };
+
+    for (GLuint* binding : bindings) {
+        if (*binding == id) {
+            *binding = 0;
+        }
+    }
+}
+
+void GLState::on_delete_texture(GLuint id) {
+    for (int i = 0; i < max_texture_units; i++) {
+        if (textures[i] == id) {
+            textures[i] = 0;
+        }
+    }
+}
@@ -0,0 +1,190 @@
+#include "main.hpp"
+
+StreamBuffer::StreamBuffer() {
+    this->target = GL_ARRAY_BUFFER;
+    this->id = 0;
+    this->region_size = 0;
+    this->region_count = 0;
+    this->region = 0;
+    this->offset = 0;
+    this->flushed = 0;
+    this->mapped = nullptr;
+    this->persistent = false;
+
+    for (int i = 0; i < max_regions; i++) {
+        this->fences[i] = nullptr;
+    }
+}
+
+StreamBuffer::~StreamBuffer() {
+    destroy();
+}
+
+bool StreamBuffer::supported() {
+    return GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+}
+
+void StreamBuffer::init(GLenum target, size_t region_size, int regions) {
+    if (regions < 1 || regions > max_regions) {
+        LOGE("stream buffer region count %d out of range", regions);
+        regions = default_regions;
+    }
+
+    this->target = target;
+    this->region_size = (region_size + region_alignment - 1) / region_alignment * region_alignment;
+    this->region_count = regions;
+    this->persistent = supported();
+
+    create();
+}
+
+void StreamBuffer::create() {
+    size_t size = this->region_size * this->region_count;
+
+    glGenBuffers(1, &this->id);
+    GLState::bind_buffer(this->target, this->id);
+
+    if (this->persistent) {
+        // coherent writes are visible to the gpu without a flush, the fences order them with draws
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage(this->target, size, nullptr, flags);
+        this->mapped = (nstd::U8*) glMapBufferRange(this->target, 0, size, flags);
+
+        if (!this->mapped) {
+            LOGE("stream buffer persistent map failed");
+        }
+    } else {
+        glBufferData(this->target, size, nullptr, GL_STREAM_DRAW);
+        this->mapped = (nstd::U8*) check_alloc(malloc(size));
+    }
+
+    this->region = 0;
+    this->offset = 0;
+    this->flushed = 0;
+}
+
+void StreamBuffer::destroy() {
+    if (!this->id) {
+        return;
+    }
+
+    for (int i = 0; i < this->region_count; i++) {
+        wait(i);
+    }
+
+    if (this->persistent) {
+        GLState::bind_buffer(this->target, this->id);
+        glUnmapBuffer(this->target);
+    } else {
+        free(this->mapped);
+    }
+
+    GLState::on_delete_buffer(this->id);
+    glDeleteBuffers(1, &this->id);
+
+    this->id = 0;
+    this->mapped = nullptr;
+}
+
+bool StreamBuffer::wait(int region) {
+    GLsync fence = this->fences[region];
+    if (!fence) {
+        return true;
+    }
+
+    // flush once so the fence is guaranteed to signal, then poll in slices up to the limit
+    static constexpr GLuint64 slice_ns = 1000000;
+
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    GLenum result = GL_TIMEOUT_EXPIRED;
+
+    for (GLuint64 waited = 0; waited < max_wait_ns && result == GL_TIMEOUT_EXPIRED; waited += slice_ns) {
+        result = glClientWaitSync(fence, flags, slice_ns);
+        flags = 0;
+    }
+
+    // anything else is a timeout, a failed wait or no current context
+    bool signaled = result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+    if (!signaled) {
+        LOGE("stream buffer region %d fence wait failed (%04x)", region, result);
+    }
+
+    glDeleteSync(fence);
+    this->fences[region] = nullptr;
+    return signaled;
+}
+
+void StreamBuffer::begin_frame() {
+    this->region = (this->region + 1) % this->region_count;
+    this->offset = 0;
+    this->flushed = 0;
+
+    wait(this->region);
+}
+
+void* StreamBuffer::alloc(size_t size, size_t alignment, size_t* offset) {
+    size_t start = (this->offset + alignment - 1) / alignment * alignment;
+
+    if (!this->mapped || start + size > this->region_size) {
+        LOGE("stream buffer region full, %zu of %zu bytes requested", start + size, this->region_size);
+        return nullptr;
+    }
+
+    this->offset = start + size;
+    *offset = this->region * this->region_size + start;
+    return this->mapped + *offset;
+}
+
+ptrdiff_t StreamBuffer::write(const void* data, size_t size, size_t alignment) {
+    size_t offset;
+    void* dst = alloc(size, alignment, &offset);
+
+    if (!dst) {
+        return -1;
+    }
+
+    memcpy(dst, data, size);
+    return (ptrdiff_t) offset;
+}
+
+void StreamBuffer::flush() {
+    if (this->persistent || this->offset <= this->flushed) {
+        return;
+    }
+
+    size_t start = this->region * this->region_size + this->flushed;
+
+    GLState::bind_buffer(this->target, this->id);
+    glBufferSubData(this->target, start, this->offset - this->flushed, this->mapped + start);
+    this->flushed = this->offset;
+}
+
+void StreamBuffer::end_frame() {
+    if (!this->id) {
+        return;
+    }
+
+    flush();
+
+    if (this->fences[this->region]) {
+        glDeleteSync(this->fences[this->region]);
+    }
+
+    this->fences[this->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::reserve(size_t region_size) {
+    if (region_size <= this->region_size) {
+        return;
+    }
+
+    destroy();
+    region_size = nstd::max(region_size, this->region_size * 2);
+    this->region_size = (region_size + region_alignment - 1) / region_alignment * region_alignment;
+    create();
+}
+
+void StreamBuffer::bind() const {
+    GLState::bind_buffer(this->target, this->id);
+}
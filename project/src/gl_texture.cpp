@@ -14,8 +14,10 @@ Texture::Texture(const char* file, TextureType type, GLuint tex_idx) {
 
 // destroys texture
 Texture::~Texture() {
-    unbind();
-    glDeleteTextures(1, &this->id);
+    if (this->state == TEXST_LOADED) {
+        GLState::on_delete_texture(this->id);
+        glDeleteTextures(1, &this->id);
+    }
 }
 
 // load texture into class
@@ -48,8 +50,7 @@ void Texture::load(const char* file, TextureType type) {
     // load the texture
     GLuint texture;
     glGenTextures(1, &texture);
-    glActiveTexture(this->tex_unit);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    GLState::bind_texture(this->tex_unit, texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -57,7 +58,7 @@ void Texture::load(const char* file, TextureType type) {
     glTexImage2D(GL_TEXTURE_2D, 0, colmod, iw, ih, 0, colmod, GL_UNSIGNED_BYTE, bytes);
     glGenerateMipmap(GL_TEXTURE_2D);
     stbi_image_free(bytes);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bind_texture(this->tex_unit, 0);
 
     this->id = texture;
     this->state = TEXST_LOADED;
@@ -78,11 +79,10 @@ void Texture::bind() const {
         return;
     }
 
-    glActiveTexture(this->tex_unit);
-    glBindTexture(GL_TEXTURE_2D, this->id);
+    GLState::bind_texture(this->tex_unit, this->id);
 }
 
-// unbinds all textures
+// unbinds the texture on the active unit
 void Texture::unbind() {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bind_texture(0);
 }
\ No newline at end of file
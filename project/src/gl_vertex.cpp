@@ -0,0 +1,73 @@
+#include "main.hpp"
+
+// float to ieee half, rounds to nearest, flushes half denormals to zero
+static nstd::U16 float_to_half(float f) {
+    nstd::U32 bits;
+    memcpy(&bits, &f, sizeof(bits));
+
+    nstd::U32 sign = (bits >> 16) & 0x8000;
+    nstd::S32 exponent = (nstd::S32) ((bits >> 23) & 0xFF) - 127 + 15;
+    nstd::U32 mantissa = bits & 0x7FFFFF;
+
+    // nan and infinity
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        return (nstd::U16) (sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+
+    if (exponent <= 0) {
+        return (nstd::U16) sign;
+    }
+
+    if (exponent >= 31) {
+        return (nstd::U16) (sign | 0x7C00);
+    }
+
+    nstd::U32 half = sign | ((nstd::U32) exponent << 10) | (mantissa >> 13);
+
+    // round to nearest, a carry into the exponent is still correct
+    if (mantissa & 0x1000) {
+        half++;
+    }
+
+    return (nstd::U16) half;
+}
+
+static nstd::U32 pack_snorm10(float v) {
+    float clamped = std::clamp(v, -1.0f, 1.0f);
+    return (nstd::U32) (nstd::S32) roundf(clamped * 511.0f) & 0x3FF;
+}
+
+static nstd::U8 pack_unorm8(float v) {
+    return (nstd::U8) roundf(std::clamp(v, 0.0f, 1.0f) * 255.0f);
+}
+
+Half2 Half2::pack(glm::vec2 v) {
+    return { float_to_half(v.x), float_to_half(v.y) };
+}
+
+PackedNormal PackedNormal::pack(glm::vec3 n) {
+    return { pack_snorm10(n.x) | (pack_snorm10(n.y) << 10) | (pack_snorm10(n.z) << 20) };
+}
+
+Unorm8x4 Unorm8x4::pack(glm::vec4 c) {
+    return { pack_unorm8(c.x), pack_unorm8(c.y), pack_unorm8(c.z), pack_unorm8(c.w) };
+}
+
+VertexCompact VertexCompact::pack(const Vertex& v) {
+    return {
+        .position = v.position,
+        .normal = PackedNormal::pack(v.normal),
+        .color = Unorm8x4::pack(v.color),
+        .texUV = Half2::pack(v.texUV),
+    };
+}
+
+std::vector<VertexCompact> VertexCompact::pack(const std::vector<Vertex>& vertices) {
+    std::vector<VertexCompact> packed(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        packed[i] = pack(vertices[i]);
+    }
+
+    return packed;
+}
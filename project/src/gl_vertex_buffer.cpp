@@ -1,21 +1,28 @@
 #include "main.hpp"
 
-VertexBuffer::VertexBuffer() {}
+VertexBuffer::VertexBuffer() {
+    this->id = 0;
+}
 
 VertexBuffer::~VertexBuffer() {
+    GLState::on_delete_buffer(this->id);
     glDeleteBuffers(1, &this->id);
 }
 
 void VertexBuffer::init(const std::vector<Vertex>& vertices) {
+    init(vertices.data(), vertices.size() * sizeof(Vertex));
+}
+
+void VertexBuffer::init(const void* data, size_t size) {
     glGenBuffers(1, &this->id);
-    glBindBuffer(GL_ARRAY_BUFFER, this->id);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    GLState::bind_buffer(GL_ARRAY_BUFFER, this->id);
+    glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
 void VertexBuffer::bind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, this->id);
+    GLState::bind_buffer(GL_ARRAY_BUFFER, this->id);
 }
 
 void VertexBuffer::unbind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::bind_buffer(GL_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "main.hpp"
+
+static constexpr GLuint empty_slot = ~0u;
+
+// smallest power of two table with at least twice as many slots as entries
+static size_t table_size(size_t entries) {
+    size_t size = 16;
+    while (size < entries * 2) {
+        size <<= 1;
+    }
+
+    return size;
+}
+
+// worker owning a hash, independent of the table's low bits
+static size_t hash_owner(nstd::U32 hash, int workers) {
+    return (size_t) (((nstd::U64) hash * (nstd::U64) workers) >> 32);
+}
+
+size_t VertexWelder::generate_remap(
+    GLuint* remap,
+    const void* vertices,
+    size_t vertex_count,
+    size_t vertex_size,
+    size_t position_offset,
+    float epsilon,
+    int threads
+) {
+    if (vertex_count == 0) {
+        return 0;
+    }
+
+    int workers = Parallel::worker_count(vertex_count, min_parallel_vertices, threads);
+    const nstd::U8* keys = (const nstd::U8*) vertices;
+
+    // -0.0 and 0.0 differ bytewise, an exact weld only needs a copy when a position has one
+    bool canonicalize = epsilon > 0.0f;
+    for (size_t i = 0; i < vertex_count && !canonicalize; i++) {
+        for (int k = 0; k < 3; k++) {
+            nstd::U32 bits;
+            memcpy(&bits, keys + i * vertex_size + position_offset + k * sizeof(float), sizeof(bits));
+            canonicalize = canonicalize || bits == 0x80000000u;
+        }
+    }
+
+    // canonical copies stand in for the vertices, with an epsilon the grid cell replaces the position bits
+    std::vector<nstd::U8> snapped;
+    if (canonicalize) {
+        snapped.assign(keys, keys + vertex_count * vertex_size);
+
+        Parallel::for_range(vertex_count, workers, [&](int, size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                nstd::U8* position = snapped.data() + i * vertex_size + position_offset;
+
+                for (int k = 0; k < 3; k++) {
+                    float value;
+                    memcpy(&value, position + k * sizeof(float), sizeof(float));
+
+                    // adding 0.0 turns -0.0 into 0.0 and leaves everything else alone
+                    value += 0.0f;
+
+                    if (epsilon > 0.0f && value == value) {
+                        // cells past the 32 bit range are clamped, converting them would be undefined
+                        double cell = floor((double) value / epsilon + 0.5);
+                        cell = std::min(std::max(cell, (double) INT32_MIN), (double) INT32_MAX);
+
+                        nstd::S32 index = (nstd::S32) cell;
+                        memcpy(position + k * sizeof(float), &index, sizeof(index));
+                    } else {
+                        memcpy(position + k * sizeof(float), &value, sizeof(float));
+                    }
+                }
+            }
+        });
+
+        keys = snapped.data();
+    }
+
+    std::vector<nstd::U32> hashes(vertex_count);
+    Parallel::for_range(vertex_count, workers, [&](int, size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            hashes[i] = nstd::Hash::generate(keys + i * vertex_size, vertex_size, nstd::Hash::fnv1a);
+        }
+    });
+
+    // each worker dedupes the vertices whose hashes it owns, walking them in input order so the
+    // first occurrence becomes the representative, remap holds representatives until renumbered
+    Parallel::for_range(workers, workers, [&](int, size_t first, size_t last) {
+        for (size_t w = first; w < last; w++) {
+            size_t owned = 0;
+            for (size_t i = 0; i < vertex_count; i++) {
+                owned += hash_owner(hashes[i], workers) == w;
+            }
+
+            std::vector<GLuint> table(table_size(owned), empty_slot);
+            size_t mask = table.size() - 1;
+
+            for (size_t i = 0; i < vertex_count; i++) {
+                if (hash_owner(hashes[i], workers) != w) {
+                    continue;
+                }
+
+                const nstd::U8* key = keys + i * vertex_size;
+                size_t slot = hashes[i] & mask;
+
+                while (table[slot] != empty_slot) {
+                    GLuint other = table[slot];
+                    if (hashes[other] == hashes[i] && memcmp(keys + (size_t) other * vertex_size, key, vertex_size) == 0) {
+                        break;
+                    }
+
+                    slot = (slot + 1) & mask;
+                }
+
+                if (table[slot] == empty_slot) {
+                    table[slot] = (GLuint) i;
+                }
+
+                remap[i] = table[slot];
+            }
+        }
+    });
+
+    // representatives precede their duplicates, so theirs are renumbered first
+    size_t unique = 0;
+    for (size_t i = 0; i < vertex_count; i++) {
+        remap[i] = remap[i] == i ? (GLuint) unique++ : remap[remap[i]];
+    }
+
+    return unique;
+}
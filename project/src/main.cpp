@@ -41,7 +41,7 @@ std::vector<Vertex> cubeVertices = {
     {{ 0.5f, -0.5f, -0.5f}, {0.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}, {1.0f, 0.0f}}  // back right
 };
 
-std::vector<Vertex> lightVertices = {
+std::vector<VertexPosition> lightVertices = {
     // Front face
     {{ 0.1f,  0.1f, 0.1f}}, // top right
     {{-0.1f,  0.1f, 0.1f}}, // top left
@@ -135,30 +135,47 @@ void handle_cursor_lock(GLFWwindow* window) {
     }
 }
 
-int main(void)
-{
-    GLFWwindow* window;
+// true on the frame F1 is released, dumps the frame counters
+bool handle_stats_key(GLFWwindow* window) {
+    static bool f1_was_pressed = false;
 
-    if (!glfwInit())
-        return -1;
+    int f1_state = glfwGetKey(window, GLFW_KEY_F1);
+    bool released = f1_state == GLFW_RELEASE && f1_was_pressed;
 
-    window = glfwCreateWindow(sw, sh, "Hello World", NULL, NULL);
-    if (!window)
-    {
-        glfwTerminate();
-        return -1;
+    f1_was_pressed = (f1_state == GLFW_PRESS);
+    return released;
+}
+
+// bundles every file in shaders/ into the pack mounted at startup, run from the build directory
+static int pack_shaders(const char* pack_path) {
+    std::vector<std::string> files;
+
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("shaders")) {
+        if (entry.is_regular_file() && entry.path().extension() != ".pak") {
+            files.push_back("shaders/" + entry.path().filename().string());
+        }
     }
 
-    glfwMakeContextCurrent(window);
+    std::sort(files.begin(), files.end());
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        LOGE("glad init failed");
-        glfwDestroyWindow(window);
-        glfwTerminate();
+    std::vector<const char*> paths;
+    for (const std::string& file : files) {
+        paths.push_back(file.c_str());
+    }
+
+    if (!ShaderSource::write_pack(pack_path, paths.data(), (int) paths.size())) {
         return -1;
     }
 
+    LOGI("packed %zu shader files into %s", paths.size(), pack_path);
+    return 0;
+}
+
+// sets up the scene and runs the frame loop until the window closes
+static void run(GLFWwindow* window, const char* shader_pack) {
+    GLState::reset();
+    ShaderProgram::init_parallel_compile();
+
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
@@ -183,16 +200,133 @@ int main(void)
     Light light1(glm::vec4(1.0, 0.0, 0.0, 1.0));
     Light light2(glm::vec4(0.0, 0.0, 1.0, 1.0));
 
+    LightSet lights;
+    lights.add(light1, &light_object1);
+    lights.add(light2, &light_object2);
+
+    // meshes share one set of buffers of packed vertices and are drawn with base vertex offsets
+    GeometryArena geometry;
+    geometry.init<VertexCompact>();
+
+    // reorder the cube for the post-transform cache, the vertices are remapped so the base plate gets a copy
+    std::vector<VertexCompact> cubeCompact = VertexCompact::pack(cubeVertices);
+    std::vector<VertexCompact> optimizedCube = cubeCompact;
+    std::vector<GLuint> optimizedCubeIndices = cubeIndicies;
+
+    MeshOptimizer::Report cube_report = MeshOptimizer::optimize(&optimizedCube, &optimizedCubeIndices);
+    MeshOptimizer::log_report("cube", &cube_report);
+
+    // the light cube has no per face attributes, welding its faces leaves the 8 corners
+    std::vector<VertexPosition> lightSoup;
+    for (GLuint index : cubeIndicies) {
+        lightSoup.push_back(lightVertices[index]);
+    }
+
+    std::vector<VertexPosition> lightCorners;
+    std::vector<GLuint> lightCornerIndices;
+    VertexWelder::weld(lightSoup.data(), lightSoup.size(), &lightCorners, &lightCornerIndices);
+
+    // and few enough vertices for 16 bit indices
+    std::vector<nstd::U16> lightIndices;
+    MeshOptimizer::narrow_indices(lightCornerIndices.data(), lightCornerIndices.size(), &lightIndices);
+
+    // simplified levels share the cube's vertices, far objects draw one of them
+    MeshSimplifier::Chain cubeLods = MeshSimplifier::build_lods(optimizedCube, optimizedCubeIndices);
+
     // load a mesh
-    Mesh cubeMesh(cubeVertices, cubeIndicies);
-    Mesh lightMesh(lightVertices, cubeIndicies);
-    Mesh basePlateMesh(cubeVertices, basePlateIndices);
+    Mesh cubeMesh(optimizedCube, cubeLods, &geometry);
+    Mesh lightMesh(lightCorners, lightIndices);
+    Mesh basePlateMesh(cubeCompact, basePlateIndices, &geometry);
+
+    // models are baked into a mesh file on the first run and rebaked when their source changes,
+    // other runs upload straight from its mapping
+    SceneObject model_object(glm::vec3(-3, 1, 0));
+    std::vector<std::unique_ptr<Mesh>> sphereMeshes;
+    MeshFile sphereFile;
+
+    if (!sphereFile.open("assets/sphere.mesh") || !sphereFile.matches_source("assets/sphere.obj")) {
+        ModelImporter::Model sphereModel;
+        sphereFile.close();
+
+        if (ModelImporter::load("assets/sphere.obj", &sphereModel, false) && 
+            ModelImporter::write_mesh_file<VertexCompact>("assets/sphere.mesh", &sphereModel, &MeshSimplifier::default_settings, "assets/sphere.obj")) {
+            sphereFile.open("assets/sphere.mesh");
+        }
+    }
+
+    for (nstd::U32 i = 0; sphereFile.header && i < sphereFile.header->submesh_count; i++) {
+        sphereMeshes.push_back(std::make_unique<Mesh>(&sphereFile, i, &geometry));
+    }
+
+    sphereFile.close();
+
+    // clusters left after culling, reused every frame
+    std::vector<nstd::U32> visibleMeshlets;
+    std::vector<MeshletSet::Range> meshletRanges;
+
+    // linked programs are reused across runs
+    ShaderCache shader_cache;
+    shader_cache.init();
+
+    // shader sources come from the pack when one was built, otherwise from the loose files
+    ShaderSource::mount_pack(shader_pack);
+
+    // lit shader specialized per light count
+    ShaderLibrary lit_shaders(&shader_cache);
+    lit_shaders.add_stage("shaders/triangle.frag");
+    lit_shaders.add_stage("shaders/triangle.vert");
+    int light_count_option = lit_shaders.add_option("LIGHT_COUNT", 4, Light::max_lights);
+    lit_shaders.add_option("NO_SPECULAR");
+
+    // the generic variant is waited on, the specialized ones compile in the background
+    nstd::U32 lit_mask = lit_shaders.option_bits(light_count_option, (nstd::U32) lights.count());
+    lit_shaders.request(lit_mask);
+    ShaderProgram* generic_shader = lit_shaders.get(0);
+
+    // the whole scene goes out in one multi draw when the driver supports it
+    bool multi_draw = DrawList::supported();
+
+    ShaderLibrary mdi_shaders(&shader_cache);
+    mdi_shaders.add_stage("shaders/triangle.frag");
+    mdi_shaders.add_stage("shaders/triangle_mdi.vert");
+    mdi_shaders.add_option("LIGHT_COUNT", 4, Light::max_lights);
+    mdi_shaders.add_option("NO_SPECULAR");
+
+    DrawList draw_list;
+    draw_list.init(&geometry);
+
+    // without multi draw, draws are sorted by state and depth before they are issued
+    RenderQueue render_queue;
+
+    // the cubes are rasterized on the cpu as occluders, meshes behind them are not submitted
+    OcclusionBuffer occlusion;
+    occlusion.init();
+
+    // multi draws are frustum culled on the gpu once the cull pass has linked
+    bool gpu_culling = multi_draw && DrawList::culling_supported();
+
+    ShaderLibrary cull_shaders(&shader_cache);
+    cull_shaders.add_stage("shaders/cull.comp");
+
+    if (multi_draw) {
+        mdi_shaders.request(lit_mask);
+    }
+
+    if (gpu_culling) {
+        cull_shaders.request(0);
+    }
+
+    // shader edits are rebuilt in the background and swapped in once linked
+    ShaderWatcher shader_watcher;
+    lit_shaders.watch(&shader_watcher);
+    mdi_shaders.watch(&shader_watcher);
+    cull_shaders.watch(&shader_watcher);
+    std::vector<std::string> changed_shaders;
 
-    // create a shader program
-    ShaderProgram shader;
-    shader.add("shaders/triangle.frag");
-    shader.add("shaders/triangle.vert");
-    shader.link();
+    // per frame uniforms, interned once instead of on every set
+    const nstd::U32 num_lights_uniform = nstd::StringTable::intern("numLights");
+    const nstd::U32 view_uniform = nstd::StringTable::intern("view");
+    const nstd::U32 camera_position_uniform = nstd::StringTable::intern("cameraPosition");
 
     int dx = 1;
     int dz = 1;
@@ -204,6 +338,38 @@ int main(void)
         double dt = curtime - prevtime;
         prevtime = curtime;
 
+        GLState::begin_frame();
+
+        if (shader_watcher.poll(curtime, &changed_shaders)) {
+            bool reload = false;
+
+            bool reload_mdi = false;
+            bool reload_cull = false;
+
+            for (const std::string& path : changed_shaders) {
+                ShaderSource::invalidate(path.c_str());
+                reload = reload || lit_shaders.depends_on(path);
+                reload_mdi = reload_mdi || mdi_shaders.depends_on(path);
+                reload_cull = reload_cull || cull_shaders.depends_on(path);
+            }
+
+            if (reload) {
+                lit_shaders.reload();
+            }
+
+            if (reload_mdi) {
+                mdi_shaders.reload();
+            }
+
+            if (reload_cull) {
+                cull_shaders.reload();
+            }
+        }
+
+        lit_shaders.poll();
+        mdi_shaders.poll();
+        cull_shaders.poll();
+
         /*
             update call
         */
@@ -226,21 +392,114 @@ int main(void)
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.1, 0.1, 0.1, 1.0);
 
+        // draw with the generic shader until the specialized one has linked
+        ShaderProgram* mdi_shader = multi_draw ? mdi_shaders.get_ready(lit_mask) : nullptr;
+        ShaderProgram& shader = mdi_shader ? *mdi_shader : *lit_shaders.get_ready(lit_mask, generic_shader);
+
         shader.activate();
-        light1.render(&shader, &light_object1, 0);
-        light2.render(&shader, &light_object2, 1);
-        shader.set_uniform_1i("numLights", 2);
+        // specialized variants have the light count compiled in, only the generic one reads it
+        if (&shader == generic_shader) {
+            shader.set_uniform_1i(num_lights_uniform, lights.count());
+        }
+        lights.apply(&shader);
+
+        camera.apply_viewport(&shader, view_uniform);
+        camera.apply_position(&shader, camera_position_uniform);
+
+        occlusion.begin_frame(camera.get_perspective(), camera.near_plane);
 
-        camera.apply_viewport(&shader, "view");
-        camera.apply_position(&shader, "cameraPosition");
+        // every counter holds the previous frame here, the render queue submits below
+        if (handle_stats_key(window)) {
+            GLState::log_last_frame();
+            render_queue.log_stats();
+            occlusion.log_stats();
+        }
+
+        occlusion.add_occluder(optimizedCube, optimizedCubeIndices, mesh_object.get_model_matrix());
+        occlusion.add_occluder(optimizedCube, optimizedCubeIndices, mesh_object1.get_model_matrix());
+        occlusion.rasterize();
+
+        if (mdi_shader) {
+            draw_list.clear();
+            draw_list.add(&cubeMesh, &mesh_object, 0, cubeMesh.select_lod(&camera, &mesh_object));
+            draw_list.add(&cubeMesh, &mesh_object1, 0, cubeMesh.select_lod(&camera, &mesh_object1));
+            draw_list.add(&basePlateMesh, &base_plate_object);
+
+            // at full detail only the clusters in view and facing the camera are drawn
+            for (const std::unique_ptr<Mesh>& mesh : sphereMeshes) {
+                if (!occlusion.visible(mesh->bounds_min, mesh->bounds_max, model_object.get_model_matrix())) {
+                    continue;
+                }
+
+                int lod = mesh->select_lod(&camera, &model_object);
+
+                if (lod == 0 && !mesh->meshlets.meshlets.empty()) {
+                    mesh->meshlets.cull(&camera, &model_object, &visibleMeshlets);
+                    mesh->meshlets.get_ranges(visibleMeshlets, &meshletRanges);
+                    draw_list.add(mesh.get(), &model_object, meshletRanges.data(), meshletRanges.size());
+                } else {
+                    draw_list.add(mesh.get(), &model_object, 0, lod);
+                }
+            }
+
+            draw_list.submit(mdi_shader, gpu_culling ? cull_shaders.get_ready(0) : nullptr, &camera);
+        } else {
+            render_queue.clear();
+            render_queue.add(RenderQueue::QUEUE_PASS_OPAQUE, &cubeMesh, &shader, &mesh_object, &camera, cubeMesh.select_lod(&camera, &mesh_object));
+            render_queue.add(RenderQueue::QUEUE_PASS_OPAQUE, &cubeMesh, &shader, &mesh_object1, &camera, cubeMesh.select_lod(&camera, &mesh_object1));
+            render_queue.add(RenderQueue::QUEUE_PASS_OPAQUE, &basePlateMesh, &shader, &base_plate_object, &camera);
 
-        cubeMesh.draw(&shader, &mesh_object);
-        cubeMesh.draw(&shader, &mesh_object1);
-        basePlateMesh.draw(&shader, &base_plate_object);
+            for (const std::unique_ptr<Mesh>& mesh : sphereMeshes) {
+                if (!occlusion.visible(mesh->bounds_min, mesh->bounds_max, model_object.get_model_matrix())) {
+                    continue;
+                }
+
+                render_queue.add(RenderQueue::QUEUE_PASS_OPAQUE, mesh.get(), &shader, &model_object, &camera, mesh->select_lod(&camera, &model_object));
+            }
+
+            render_queue.submit();
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+}
+
+int main(int argc, char** argv)
+{
+    // shader pack path, relative to the build directory
+    const char* shader_pack = "shaders/shaders.pak";
+
+    if (argc > 1 && strcmp(argv[1], "--pack-shaders") == 0) {
+        return pack_shaders(shader_pack);
+    }
+
+    GLFWwindow* window;
+
+    if (!glfwInit())
+        return -1;
+
+    window = glfwCreateWindow(sw, sh, "Hello World", NULL, NULL);
+    if (!window)
+    {
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        LOGE("glad init failed");
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return -1;
+    }
+
+    // every gl object of the scene is released when run returns, before the context goes away
+    run(window, shader_pack);
+
+    ShaderSource::release();
 
     glfwTerminate();
     return 0;
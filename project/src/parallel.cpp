@@ -0,0 +1,134 @@
+#include "main.hpp"
+
+/*
+    worker pool
+*/
+
+// slices of one run_slices call still running, the caller sleeps until they are done
+typedef struct {
+    size_t remaining;
+    std::mutex lock;
+    std::condition_variable done;
+} Batch;
+
+typedef struct {
+    void (*run)(void* context, size_t slice);
+    void* context;
+    size_t slice;
+    Batch* batch;
+} Job;
+
+struct WorkerPool {
+    static constexpr size_t queue_capacity = 1024;
+
+    nstd::MpmcQueue<Job>* queue;
+    std::counting_semaphore<> ready;
+    std::atomic<bool> stopping;
+    std::vector<std::thread> threads;
+
+    WorkerPool() : ready(0) {
+        this->queue = nstd::MpmcQueue<Job>::create(queue_capacity);
+        this->stopping.store(false, std::memory_order_relaxed);
+
+        // the thread calling for_range is the first worker of every batch
+        for (int i = 1; i < Parallel::thread_count(); i++) {
+            this->threads.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~WorkerPool() {
+        this->stopping.store(true, std::memory_order_release);
+        this->ready.release((std::ptrdiff_t) this->threads.size());
+
+        for (std::thread& thread : this->threads) {
+            thread.join();
+        }
+
+        nstd::MpmcQueue<Job>::destroy(this->queue);
+    }
+
+    static void execute(const Job* job) {
+        job->run(job->context, job->slice);
+
+        // the caller only returns after taking the lock, so the batch outlives this
+        std::lock_guard<std::mutex> guard(job->batch->lock);
+        if (--job->batch->remaining == 0) {
+            job->batch->done.notify_all();
+        }
+    }
+
+    // a wake up can find the queue empty when the caller helped itself to the job
+    void work() {
+        while (true) {
+            this->ready.acquire();
+
+            if (this->stopping.load(std::memory_order_acquire)) {
+                return;
+            }
+
+            Job job;
+            if (nstd::MpmcQueue<Job>::pop(this->queue, &job)) {
+                execute(&job);
+            }
+        }
+    }
+};
+
+// started on first use, static init is thread safe
+static WorkerPool* worker_pool() {
+    static WorkerPool pool;
+    return &pool;
+}
+
+/*
+    parallel
+*/
+
+int Parallel::thread_count() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count ? (int) count : 1;
+}
+
+int Parallel::worker_count(size_t count, size_t min_per_worker, int threads) {
+    if (threads <= 0) {
+        threads = thread_count();
+    }
+
+    size_t workers = min_per_worker ? count / min_per_worker : count;
+    return (int) nstd::max((size_t) 1, nstd::min(workers, (size_t) threads));
+}
+
+void Parallel::run_slices(size_t slices, void (*run)(void* context, size_t slice), void* context) {
+    WorkerPool* pool = worker_pool();
+
+    Batch batch;
+    batch.remaining = slices;
+
+    // slices that do not fit the queue run here
+    std::ptrdiff_t queued = 0;
+    for (size_t slice = 1; slice < slices; slice++) {
+        Job job = { run, context, slice, &batch };
+
+        if (nstd::MpmcQueue<Job>::push(pool->queue, job)) {
+            queued++;
+        } else {
+            WorkerPool::execute(&job);
+        }
+    }
+
+    if (queued) {
+        pool->ready.release(queued);
+    }
+
+    Job first = { run, context, 0, &batch };
+    WorkerPool::execute(&first);
+
+    // help with whatever is queued, nested loops on the workers can not starve this way
+    Job job;
+    while (nstd::MpmcQueue<Job>::pop(pool->queue, &job)) {
+        WorkerPool::execute(&job);
+    }
+
+    std::unique_lock<std::mutex> guard(batch.lock);
+    batch.done.wait(guard, [&batch]() { return batch.remaining == 0; });
+}
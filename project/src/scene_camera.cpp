@@ -54,7 +54,36 @@ glm::mat4 Camera::get_perspective() const {
     return projection * view;
 }
 
-void Camera::apply_viewport(const ShaderProgram* shader, const char* uniform) const {
+void Camera::frustum_planes(const glm::mat4& m, float planes[6][4]) {
+    // left, right, bottom, top, near, far from the rows of the matrix (Gribb and Hartmann)
+    for (int p = 0; p < 6; p++) {
+        int row = p / 2;
+        float sign = (p % 2) ? -1.0f : 1.0f;
+
+        for (int k = 0; k < 4; k++) {
+            planes[p][k] = m[k][3] + sign * m[k][row];
+        }
+
+        float length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        if (length > 0.0f) {
+            for (int k = 0; k < 4; k++) {
+                planes[p][k] /= length;
+            }
+        }
+    }
+}
+
+float Camera::projected_size(glm::vec3 center, float radius) const {
+    int width, height;
+    glfwGetFramebufferSize(this->window, &width, &height);
+
+    // a sphere around the camera covers the screen, size it as if touching the near side
+    float distance = std::max(glm::length(center - this->object_binding->position), radius);
+
+    return radius / (distance * tanf(glm::radians(this->fov) * 0.5f)) * (float) height;
+}
+
+void Camera::apply_viewport(const ShaderProgram* shader, nstd::U32 uniform) const {
     // apply camera perspective
     shader->set_uniform_matrix_4fv(
         uniform, 
@@ -62,7 +91,7 @@ void Camera::apply_viewport(const ShaderProgram* shader, const char* uniform) co
     );
 }
 
-void Camera::apply_position(const ShaderProgram* shader, const char* uniform) const {
+void Camera::apply_position(const ShaderProgram* shader, nstd::U32 uniform) const {
     // apply camera perspective
     shader->set_uniform_3fv(
         uniform, 
@@ -1,5 +1,33 @@
 #include "main.hpp"
 
+typedef enum {
+    LIGHT_UNI_COLOR,
+    LIGHT_UNI_POSITION,
+    LIGHT_UNI_INTENSITY,
+    LIGHT_UNI_BRIGHTNESS,
+    LIGHT_UNI_MAX,
+} LightUniform;
+
+static constexpr const char* light_uniform_fields[LIGHT_UNI_MAX] = {
+    [LIGHT_UNI_COLOR] = "Color",
+    [LIGHT_UNI_POSITION] = "Position",
+    [LIGHT_UNI_INTENSITY] = "Intensity",
+    [LIGHT_UNI_BRIGHTNESS] = "Brightness",
+};
+
+// interned "lights[idx].Field" names, built on first use
+static nstd::U32 light_uniform(int idx, LightUniform field) {
+    static nstd::U32 names[Light::max_lights][LIGHT_UNI_MAX] = { };
+
+    if (!names[idx][field]) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "lights[%i].%s", idx, light_uniform_fields[field]);
+        names[idx][field] = nstd::StringTable::intern(buf);
+    }
+
+    return names[idx][field];
+}
+
 Light::Light(glm::vec4 color) {
     this->color = color;
     this->intensity = 1.0f;
@@ -23,10 +51,48 @@ void Light::set_brightness(float brightness) {
 }
 
 void Light::render(const ShaderProgram* shader, const SceneObject* binding, int idx) const {
-    std::string shaderReference = "lights[" + std::to_string(idx) + "]";
+    if (idx < 0 || idx >= max_lights) {
+        LOGE("light index %i out of range", idx);
+        return;
+    }
+
+    shader->set_uniform_4fv(light_uniform(idx, LIGHT_UNI_COLOR), glm::value_ptr(this->color));
+    shader->set_uniform_3fv(light_uniform(idx, LIGHT_UNI_POSITION), glm::value_ptr(binding->position));
+    shader->set_uniform_1f(light_uniform(idx, LIGHT_UNI_INTENSITY), this->intensity);
+    shader->set_uniform_1f(light_uniform(idx, LIGHT_UNI_BRIGHTNESS), this->brightness);
+}
+
+LightSet::LightSet() {
+    this->lights = Lights::create(Light::max_lights);
+}
 
-    shader->set_uniform_4fv((shaderReference + ".Color").c_str(), glm::value_ptr(this->color));
-    shader->set_uniform_3fv((shaderReference + ".Position").c_str(), glm::value_ptr(binding->position));
-    shader->set_uniform_1f((shaderReference + ".Intensity").c_str(), this->intensity);
-    shader->set_uniform_1f((shaderReference + ".Brightness").c_str(), this->brightness);
-}
\ No newline at end of file
+LightSet::~LightSet() {
+    Lights::destroy(this->lights);
+}
+
+int LightSet::add(const Light& light, const SceneObject* binding) {
+    if (count() >= Light::max_lights) {
+        LOGE("light set is full (%i lights)", Light::max_lights);
+        return -1;
+    }
+
+    return (int) Lights::push_back(this->lights, light.color, light.intensity, light.brightness, binding);
+}
+
+int LightSet::count() const {
+    return (int) Lights::size(this->lights);
+}
+
+void LightSet::apply(const ShaderProgram* shader) const {
+    nstd::Span<glm::vec4> colors = Lights::span<LIGHT_FIELD_COLOR>(this->lights);
+    nstd::Span<float> intensities = Lights::span<LIGHT_FIELD_INTENSITY>(this->lights);
+    nstd::Span<float> brightnesses = Lights::span<LIGHT_FIELD_BRIGHTNESS>(this->lights);
+    nstd::Span<const SceneObject*> bindings = Lights::span<LIGHT_FIELD_BINDING>(this->lights);
+
+    for (int idx = 0; idx < (int) colors.len; idx++) {
+        shader->set_uniform_4fv(light_uniform(idx, LIGHT_UNI_COLOR), glm::value_ptr(colors[idx]));
+        shader->set_uniform_3fv(light_uniform(idx, LIGHT_UNI_POSITION), glm::value_ptr(bindings[idx]->position));
+        shader->set_uniform_1f(light_uniform(idx, LIGHT_UNI_INTENSITY), intensities[idx]);
+        shader->set_uniform_1f(light_uniform(idx, LIGHT_UNI_BRIGHTNESS), brightnesses[idx]);
+    }
+}
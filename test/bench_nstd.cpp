@@ -0,0 +1,371 @@
+// g++ -std=c++20 -O2 bench_nstd.cpp nstd.cpp -o bench_nstd
+// usage: bench_nstd [--json] [--quick]
+#include "nstd.hpp"
+
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+
+using namespace nstd;
+
+static volatile U64 sink;
+
+static U64 now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+/*
+    result collection
+*/
+
+struct Result {
+    const char* suite;
+    const char* container;
+    const char* pattern;
+    USZ size;
+    USZ reps;
+    F64 median_ns;
+    F64 p99_ns;
+    F64 max_ns;
+};
+
+static std::vector<Result> results;
+
+// enough runs that the 99th percentile is a sample below the slowest one
+static USZ repetitions = 101;
+
+// nearest rank percentile of sorted samples
+static F64 percentile(const std::vector<F64>& sorted, F64 fraction) {
+    USZ rank = (USZ) ceil(fraction * (F64) sorted.size());
+    return sorted[rank ? rank - 1 : 0];
+}
+
+// runs body reps times, each run returns elapsed ns for size ops
+template <typename Body>
+static void measure(const char* suite, const char* container, const char* pattern, USZ size, Body body) {
+    std::vector<F64> samples(repetitions);
+
+    // warm caches and the allocator once before sampling
+    body();
+
+    for (USZ r = 0; r < repetitions; r++) {
+        samples[r] = (F64) body() / (F64) size;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    results.push_back(Result {
+        .suite = suite,
+        .container = container,
+        .pattern = pattern,
+        .size = size,
+        .reps = repetitions,
+        .median_ns = samples[samples.size() / 2],
+        .p99_ns = percentile(samples, 0.99),
+        .max_ns = samples.back(),
+    });
+}
+
+static void write_csv() {
+    printf("suite,container,pattern,size,reps,median_ns_per_op,p99_ns_per_op,max_ns_per_op\n");
+
+    for (const Result& r : results) {
+        printf("%s,%s,%s,%zu,%zu,%.3f,%.3f,%.3f\n", r.suite, r.container, r.pattern, r.size, r.reps, r.median_ns, r.p99_ns, r.max_ns);
+    }
+}
+
+static void write_json() {
+    printf("[\n");
+
+    for (USZ i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf(
+            "  {\"suite\": \"%s\", \"container\": \"%s\", \"pattern\": \"%s\", \"size\": %zu, \"reps\": %zu, "
+            "\"median_ns_per_op\": %.3f, \"p99_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f}%s\n",
+            r.suite, r.container, r.pattern, r.size, r.reps, r.median_ns, r.p99_ns, r.max_ns,
+            (i + 1 < results.size()) ? "," : ""
+        );
+    }
+
+    printf("]\n");
+}
+
+/*
+    access patterns
+*/
+
+// order in which slots are released or probed
+static std::vector<USZ> make_order(const char* pattern, USZ size) {
+    std::vector<USZ> order(size);
+
+    for (USZ i = 0; i < size; i++) {
+        order[i] = i;
+    }
+
+    if (strcmp(pattern, "reverse") == 0) {
+        std::reverse(order.begin(), order.end());
+    } else if (strcmp(pattern, "random") == 0) {
+        std::mt19937_64 rng(size);
+        std::shuffle(order.begin(), order.end(), rng);
+    }
+
+    return order;
+}
+
+static const char* patterns[] = { "sequential", "reverse", "random" };
+
+/*
+    allocators
+*/
+
+struct Chunk {
+    U64 data[8];
+};
+
+static void bench_allocators(USZ size) {
+    for (const char* pattern : patterns) {
+        std::vector<USZ> order = make_order(pattern, size);
+        std::vector<U8*> refs(size);
+
+        measure("alloc", "FixedHeapContainer", pattern, size, [&]() -> U64 {
+            FixedHeapContainer* block = FixedHeapContainer::create(size, sizeof(Chunk));
+
+            U64 start = now_ns();
+            for (USZ i = 0; i < size; i++) {
+                refs[i] = FixedHeapContainer::insert(block, nullptr);
+            }
+            for (USZ i = 0; i < size; i++) {
+                FixedHeapContainer::remove(block, &refs[order[i]]);
+            }
+            U64 ns = now_ns() - start;
+
+            FixedHeapContainer::destroy(block);
+            return ns;
+        });
+
+        measure("alloc", "DynamicHeapContainer", pattern, size, [&]() -> U64 {
+            DynamicHeapContainer* pool = DynamicHeapContainer::create(1024, sizeof(Chunk));
+
+            U64 start = now_ns();
+            for (USZ i = 0; i < size; i++) {
+                refs[i] = DynamicHeapContainer::insert(pool, nullptr);
+            }
+            for (USZ i = 0; i < size; i++) {
+                DynamicHeapContainer::remove(pool, &refs[order[i]]);
+            }
+            U64 ns = now_ns() - start;
+
+            DynamicHeapContainer::destroy(pool);
+            return ns;
+        });
+
+        measure("alloc", "malloc", pattern, size, [&]() -> U64 {
+            U64 start = now_ns();
+            for (USZ i = 0; i < size; i++) {
+                refs[i] = (U8*) malloc(sizeof(Chunk));
+                refs[i][0] = (U8) i;
+            }
+            for (USZ i = 0; i < size; i++) {
+                free(refs[order[i]]);
+            }
+            return now_ns() - start;
+        });
+    }
+}
+
+/*
+    hash tables
+*/
+
+static void bench_tables(USZ size) {
+    std::vector<Chunk> keys(size);
+    std::vector<Chunk> vals(size);
+
+    measure("table_insert", "ReferenceTable", "sequential", size, [&]() -> U64 {
+        ReferenceTable* table = ReferenceTable::create(size);
+
+        U64 start = now_ns();
+        for (USZ i = 0; i < size; i++) {
+            ReferenceTable::insert(table, { (U8*) &keys[i], (U8*) &vals[i] });
+        }
+        U64 ns = now_ns() - start;
+
+        ReferenceTable::destroy(table);
+        return ns;
+    });
+
+    measure("table_insert", "std::unordered_map", "sequential", size, [&]() -> U64 {
+        std::unordered_map<U8*, U8*> table;
+        table.reserve(size);
+
+        U64 start = now_ns();
+        for (USZ i = 0; i < size; i++) {
+            table[(U8*) &keys[i]] = (U8*) &vals[i];
+        }
+        return now_ns() - start;
+    });
+
+    ReferenceTable* ref_table = ReferenceTable::create(size);
+    std::unordered_map<U8*, U8*> std_table;
+    std_table.reserve(size);
+
+    for (USZ i = 0; i < size; i++) {
+        ReferenceTable::insert(ref_table, { (U8*) &keys[i], (U8*) &vals[i] });
+        std_table[(U8*) &keys[i]] = (U8*) &vals[i];
+    }
+
+    for (const char* pattern : patterns) {
+        std::vector<USZ> order = make_order(pattern, size);
+
+        measure("table_find", "ReferenceTable", pattern, size, [&]() -> U64 {
+            U64 acc = 0;
+
+            U64 start = now_ns();
+            for (USZ i = 0; i < size; i++) {
+                acc += (USZ) ReferenceTable::find(ref_table, (U8*) &keys[order[i]]);
+            }
+            U64 ns = now_ns() - start;
+
+            sink = acc;
+            return ns;
+        });
+
+        measure("table_find", "std::unordered_map", pattern, size, [&]() -> U64 {
+            U64 acc = 0;
+
+            U64 start = now_ns();
+            for (USZ i = 0; i < size; i++) {
+                acc += (USZ) std_table.find((U8*) &keys[order[i]])->second;
+            }
+            U64 ns = now_ns() - start;
+
+            sink = acc;
+            return ns;
+        });
+    }
+
+    ReferenceTable::destroy(ref_table);
+}
+
+/*
+    arrays
+*/
+
+static void bench_arrays(USZ size) {
+    measure("array_push", "ExpandingArray", "sequential", size, [&]() -> U64 {
+        ExpandingArray* array = ExpandingArray::create(sizeof(U64), Data::EXPANDING_DATA_RESERVE);
+
+        U64 start = now_ns();
+        for (U64 i = 0; i < size; i++) {
+            ExpandingArray::push_back(array, (U8*) &i);
+        }
+        U64 ns = now_ns() - start;
+
+        ExpandingArray::destroy(array);
+        return ns;
+    });
+
+    measure("array_push", "std::vector", "sequential", size, [&]() -> U64 {
+        std::vector<U64> array;
+
+        U64 start = now_ns();
+        for (U64 i = 0; i < size; i++) {
+            array.push_back(i);
+        }
+        U64 ns = now_ns() - start;
+
+        sink = array.back();
+        return ns;
+    });
+
+    FixedArray* fixed = FixedArray::create(size, sizeof(U64));
+    ExpandingArray* expanding = ExpandingArray::create(sizeof(U64), Data::EXPANDING_DATA_RESERVE);
+    std::vector<U64> vector(size);
+
+    for (U64 i = 0; i < size; i++) {
+        FixedArray::insert(fixed, i, (U8*) &i);
+        ExpandingArray::push_back(expanding, (U8*) &i);
+        vector[i] = i;
+    }
+
+    for (const char* pattern : patterns) {
+        std::vector<USZ> order = make_order(pattern, size);
+
+        measure("array_read", "FixedArray", pattern, size, [&]() -> U64 {
+            U64 acc = 0;
+
+            U64 start = now_ns();
+            for (USZ i = 0; i < size; i++) {
+                acc += *(U64*) FixedArray::at(fixed, order[i]);
+            }
+            U64 ns = now_ns() - start;
+
+            sink = acc;
+            return ns;
+        });
+
+        measure("array_read", "ExpandingArray", pattern, size, [&]() -> U64 {
+            U64 acc = 0;
+
+            U64 start = now_ns();
+            for (USZ i = 0; i < size; i++) {
+                acc += *(U64*) ExpandingArray::at(expanding, order[i]);
+            }
+            U64 ns = now_ns() - start;
+
+            sink = acc;
+            return ns;
+        });
+
+        measure("array_read", "std::vector", pattern, size, [&]() -> U64 {
+            U64 acc = 0;
+
+            U64 start = now_ns();
+            for (USZ i = 0; i < size; i++) {
+                acc += vector[order[i]];
+            }
+            U64 ns = now_ns() - start;
+
+            sink = acc;
+            return ns;
+        });
+    }
+
+    FixedArray::destroy(fixed);
+    ExpandingArray::destroy(expanding);
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    std::vector<USZ> sizes = { 1 << 10, 1 << 14, 1 << 18 };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            // fewer sizes, the repetitions stay so the tail is still measured
+            sizes = { 1 << 10, 1 << 14 };
+        } else {
+            LOGE("unknown argument %s", argv[i]);
+            return 1;
+        }
+    }
+
+    for (USZ size : sizes) {
+        bench_allocators(size);
+        bench_tables(size);
+        bench_arrays(size);
+    }
+
+    if (json) {
+        write_json();
+    } else {
+        write_csv();
+    }
+
+    return 0;
+}
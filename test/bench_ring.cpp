@@ -0,0 +1,213 @@
+// g++ -std=c++20 -O2 bench_ring.cpp -o bench_ring -lpthread
+#include "nstd.hpp"
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+using namespace nstd;
+
+static constexpr USZ RING_CAPACITY = 4096;
+static constexpr USZ THROUGHPUT_ITEMS = 1 << 24;
+static constexpr USZ LATENCY_SAMPLES = 20000;
+static constexpr USZ BATCH_SIZE = 64;
+
+static U64 now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+static void report_throughput(const char* name, USZ items, U64 ns) {
+    LOGI("%-28s %8.2f Mops/s  (%.2f ns/op)", name, items * 1e3 / (F64) ns, (F64) ns / (F64) items);
+}
+
+/*
+    spsc
+*/
+
+static void spsc_throughput(bool batched) {
+    SpscRing<U64>* ring = SpscRing<U64>::create(RING_CAPACITY);
+
+    U64 start = now_ns();
+
+    std::thread consumer([ring, batched]() {
+        U64 buf[BATCH_SIZE];
+        U64 expected = 0;
+
+        while (expected < THROUGHPUT_ITEMS) {
+            USZ n = batched
+                ? SpscRing<U64>::pop_batch(ring, buf, BATCH_SIZE)
+                : (USZ) SpscRing<U64>::pop(ring, buf);
+
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+
+            for (USZ i = 0; i < n; i++) {
+                if (buf[i] != expected++) {
+                    THROW("spsc ring out of order");
+                }
+            }
+        }
+    });
+
+    U64 buf[BATCH_SIZE];
+    for (U64 i = 0; i < THROUGHPUT_ITEMS;) {
+        if (batched) {
+            USZ want = min(BATCH_SIZE, THROUGHPUT_ITEMS - i);
+            for (USZ j = 0; j < want; j++) {
+                buf[j] = i + j;
+            }
+
+            USZ n = SpscRing<U64>::push_batch(ring, buf, want);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+
+            i += n;
+        } else if (SpscRing<U64>::push(ring, i)) {
+            i++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    consumer.join();
+    report_throughput(batched ? "spsc batch" : "spsc", THROUGHPUT_ITEMS, now_ns() - start);
+
+    SpscRing<U64>::destroy(ring);
+}
+
+// round trip between two threads over a pair of rings
+static void spsc_latency() {
+    SpscRing<U64>* ping = SpscRing<U64>::create(RING_CAPACITY);
+    SpscRing<U64>* pong = SpscRing<U64>::create(RING_CAPACITY);
+
+    std::thread echo([ping, pong]() {
+        U64 v;
+
+        for (USZ i = 0; i < LATENCY_SAMPLES; i++) {
+            while (!SpscRing<U64>::pop(ping, &v)) { std::this_thread::yield(); }
+            while (!SpscRing<U64>::push(pong, v)) { std::this_thread::yield(); }
+        }
+    });
+
+    std::vector<U64> samples(LATENCY_SAMPLES);
+    U64 v;
+
+    for (USZ i = 0; i < LATENCY_SAMPLES; i++) {
+        U64 start = now_ns();
+        while (!SpscRing<U64>::push(ping, i)) { std::this_thread::yield(); }
+        while (!SpscRing<U64>::pop(pong, &v)) { std::this_thread::yield(); }
+        samples[i] = now_ns() - start;
+    }
+
+    echo.join();
+
+    std::sort(samples.begin(), samples.end());
+    LOGI("%-28s median %llu ns  p99 %llu ns", "spsc round trip",
+        (unsigned long long) samples[samples.size() / 2],
+        (unsigned long long) samples[samples.size() * 99 / 100]
+    );
+
+    SpscRing<U64>::destroy(ping);
+    SpscRing<U64>::destroy(pong);
+}
+
+/*
+    mpmc
+*/
+
+static void mpmc_throughput(USZ producers, USZ consumers, bool batched) {
+    MpmcQueue<U64>* queue = MpmcQueue<U64>::create(RING_CAPACITY);
+    USZ per_producer = THROUGHPUT_ITEMS / producers;
+    USZ total = per_producer * producers;
+
+    std::atomic<USZ> consumed = 0;
+    std::atomic<U64> checksum = 0;
+    std::vector<std::thread> threads;
+
+    U64 start = now_ns();
+
+    for (USZ p = 0; p < producers; p++) {
+        threads.emplace_back([queue, per_producer, batched]() {
+            U64 buf[BATCH_SIZE];
+
+            for (USZ i = 0; i < per_producer;) {
+                if (batched) {
+                    USZ want = min(BATCH_SIZE, per_producer - i);
+                    for (USZ j = 0; j < want; j++) {
+                        buf[j] = 1;
+                    }
+
+                    USZ n = MpmcQueue<U64>::push_batch(queue, buf, want);
+                    if (n == 0) {
+                        std::this_thread::yield();
+                    }
+
+                    i += n;
+                } else if (MpmcQueue<U64>::push(queue, 1)) {
+                    i++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (USZ c = 0; c < consumers; c++) {
+        threads.emplace_back([queue, total, batched, &consumed, &checksum]() {
+            U64 buf[BATCH_SIZE];
+            U64 sum = 0;
+
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                USZ n = batched
+                    ? MpmcQueue<U64>::pop_batch(queue, buf, BATCH_SIZE)
+                    : (USZ) MpmcQueue<U64>::pop(queue, buf);
+
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+
+                for (USZ i = 0; i < n; i++) {
+                    sum += buf[i];
+                }
+
+                consumed.fetch_add(n, std::memory_order_relaxed);
+            }
+
+            checksum.fetch_add(sum);
+        });
+    }
+
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    U64 ns = now_ns() - start;
+
+    if (checksum.load() != total) {
+        THROW("mpmc queue lost items");
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "mpmc %zup%zuc%s", producers, consumers, batched ? " batch" : "");
+    report_throughput(name, total, ns);
+
+    MpmcQueue<U64>::destroy(queue);
+}
+
+int main() {
+    spsc_throughput(false);
+    spsc_throughput(true);
+    spsc_latency();
+
+    for (USZ threads : { 1, 2, 4 }) {
+        mpmc_throughput(threads, threads, false);
+        mpmc_throughput(threads, threads, true);
+    }
+
+    return 0;
+}
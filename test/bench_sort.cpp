@@ -0,0 +1,81 @@
+// g++ -std=c++20 -O2 bench_sort.cpp nstd.cpp -o bench_sort -lpthread
+#include "nstd.hpp"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace nstd;
+
+static constexpr USZ REPETITIONS = 5;
+
+static U64 now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+// times sort over fresh copies of input and returns the median in ns
+template <typename Sorter>
+static U64 measure(const std::vector<Sort::KeyIndex>& input, Sorter sorter) {
+    std::vector<Sort::KeyIndex> items(input.size());
+    std::vector<U64> samples(REPETITIONS);
+
+    for (USZ r = 0; r < REPETITIONS; r++) {
+        std::copy(input.begin(), input.end(), items.begin());
+
+        U64 start = now_ns();
+        sorter(items.data(), items.size());
+        samples[r] = now_ns() - start;
+
+        for (USZ i = 1; i < items.size(); i++) {
+            if (items[i - 1].key > items[i].key) {
+                THROW("sort output out of order");
+            }
+        }
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return samples[REPETITIONS / 2];
+}
+
+static void bench(const char* keys, USZ count, U64 key_mask) {
+    std::mt19937_64 rng(count);
+    std::vector<Sort::KeyIndex> input(count);
+
+    for (USZ i = 0; i < count; i++) {
+        input[i] = { .key = rng() & key_mask, .index = (U32) i };
+    }
+
+    U64 std_ns = measure(input, [](Sort::KeyIndex* items, USZ n) {
+        std::stable_sort(items, items + n, [](const Sort::KeyIndex& a, const Sort::KeyIndex& b) {
+            return a.key < b.key;
+        });
+    });
+
+    U64 radix_ns = measure(input, [](Sort::KeyIndex* items, USZ n) {
+        Sort::radix(items, n);
+    });
+
+    U64 parallel_ns = measure(input, [](Sort::KeyIndex* items, USZ n) {
+        Sort::radix_parallel(items, n);
+    });
+
+    printf("%s,%zu,%.3f,%.3f,%.3f\n", keys, count, std_ns / 1e6, radix_ns / 1e6, parallel_ns / 1e6);
+}
+
+int main() {
+    LOGI("workers: %u", std::thread::hardware_concurrency());
+    printf("keys,count,std_stable_sort_ms,radix_ms,radix_parallel_ms\n");
+
+    for (USZ count : { 1000, 10000, 100000, 1000000, 10000000 }) {
+        bench("u64", count, ~0ull);
+
+        // depth or morton style keys that only use the low 32 bits
+        bench("u32", count, 0xFFFFFFFFull);
+    }
+
+    return 0;
+}
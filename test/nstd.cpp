@@ -1,5 +1,8 @@
 #include "nstd.hpp"
 
+#include <thread>
+#include <barrier>
+
 namespace nstd {
 
 #ifdef STD_HEAP_TRACK
@@ -140,8 +143,9 @@ void DynamicHeapContainer::destroy(DynamicHeapContainer* pool) {
         FixedHeapContainer* fixed = pool->root;
 
         while (fixed) {
+            FixedHeapContainer* next = fixed->next;
             FixedHeapContainer::destroy(fixed);
-            fixed = fixed->next;
+            fixed = next;
         }
 
         Mem::dealloc(pool);
@@ -546,7 +550,7 @@ USZ Pair::compare_r(const Pair* a, const Pair* b) {
     ref table
 */
 
-ReferenceTable* ReferenceTable::create(USZ width, Hash::Group hash_type = Hash::djb2) {
+ReferenceTable* ReferenceTable::create(USZ width, Hash::Group hash_type) {
     ReferenceTable* table = Mem::type_alloc<ReferenceTable>();
     table->allocator = Mem::dynamic_container<Item>(width);
     table->references = Data::list<Item*>(width);
@@ -636,4 +640,432 @@ void ReferenceTable::iterate(ReferenceTable* table, void (*it)(U8*, U8*)) {
     }
 }
 
-}
\ No newline at end of file
+/*
+    sorting
+*/
+
+static constexpr USZ RADIX_DIGITS = sizeof(U64);
+static constexpr USZ RADIX_BUCKETS = 256;
+
+static inline USZ radix_digit(U64 key, USZ digit) {
+    return (key >> (digit * 8)) & (RADIX_BUCKETS - 1);
+}
+
+// fills hist with one 256 bucket histogram per key byte
+static void radix_histograms(const Sort::KeyIndex* items, USZ count, USZ* hist) {
+    for (USZ i = 0; i < count; i++) {
+        U64 key = items[i].key;
+
+        for (USZ d = 0; d < RADIX_DIGITS; d++) {
+            hist[d * RADIX_BUCKETS + radix_digit(key, d)]++;
+        }
+    }
+}
+
+// collects the digits that actually split the keys, a byte every key shares is a no op pass
+static USZ radix_passes(const USZ* hist, USZ count, USZ* passes) {
+    USZ num_passes = 0;
+
+    for (USZ d = 0; d < RADIX_DIGITS; d++) {
+        const USZ* digit_hist = hist + d * RADIX_BUCKETS;
+        bool trivial = false;
+
+        for (USZ b = 0; b < RADIX_BUCKETS; b++) {
+            if (digit_hist[b] == count) {
+                trivial = true;
+                break;
+            }
+        }
+
+        if (!trivial) {
+            passes[num_passes++] = d;
+        }
+    }
+
+    return num_passes;
+}
+
+void Sort::insertion(KeyIndex* items, USZ count) {
+    for (USZ i = 1; i < count; i++) {
+        KeyIndex item = items[i];
+        USZ j = i;
+
+        while (j > 0 && items[j - 1].key > item.key) {
+            items[j] = items[j - 1];
+            j--;
+        }
+
+        items[j] = item;
+    }
+}
+
+void Sort::radix(KeyIndex* items, USZ count, KeyIndex* scratch) {
+    if (count <= RADIX_SORT_MIN) {
+        insertion(items, count);
+        return;
+    }
+
+    USZ hist[RADIX_DIGITS * RADIX_BUCKETS] = { 0 };
+    USZ passes[RADIX_DIGITS];
+
+    radix_histograms(items, count, hist);
+    USZ num_passes = radix_passes(hist, count, passes);
+
+    if (num_passes == 0) {
+        return;
+    }
+
+    KeyIndex* owned = nullptr;
+    if (!scratch) {
+        owned = Mem::alloc<KeyIndex>(count * sizeof(KeyIndex));
+        scratch = owned;
+    }
+
+    KeyIndex* src = items;
+    KeyIndex* dst = scratch;
+
+    for (USZ p = 0; p < num_passes; p++) {
+        USZ digit = passes[p];
+        USZ* digit_hist = hist + digit * RADIX_BUCKETS;
+
+        // exclusive prefix sum turns counts into write offsets
+        USZ offset = 0;
+        for (USZ b = 0; b < RADIX_BUCKETS; b++) {
+            USZ n = digit_hist[b];
+            digit_hist[b] = offset;
+            offset += n;
+        }
+
+        for (USZ i = 0; i < count; i++) {
+            dst[digit_hist[radix_digit(src[i].key, digit)]++] = src[i];
+        }
+
+        KeyIndex* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != items) {
+        Mem::copy(items, src, count * sizeof(KeyIndex));
+    }
+
+    Mem::dealloc(owned);
+}
+
+void Sort::radix_parallel(KeyIndex* items, USZ count, USZ workers, KeyIndex* scratch) {
+    if (workers == 0) {
+        workers = max(std::thread::hardware_concurrency(), 1);
+    }
+
+    if (workers == 1 || count < RADIX_SORT_PARALLEL_MIN) {
+        radix(items, count, scratch);
+        return;
+    }
+
+    KeyIndex* owned = nullptr;
+    if (!scratch) {
+        owned = Mem::alloc<KeyIndex>(count * sizeof(KeyIndex));
+        scratch = owned;
+    }
+
+    // per worker histograms: all digits for pass selection, then one digit per pass
+    USZ* digit_hists = Mem::alloc<USZ>(workers, RADIX_DIGITS * RADIX_BUCKETS * sizeof(USZ));
+    USZ* pass_hists = Mem::alloc<USZ>(workers * RADIX_BUCKETS * sizeof(USZ));
+    USZ chunk = (count + workers - 1) / workers;
+    bool result_in_scratch = false;
+
+    std::barrier sync((std::ptrdiff_t) workers);
+
+    auto work = [&](USZ w) {
+        USZ lo = min(w * chunk, count);
+        USZ hi = min(lo + chunk, count);
+        USZ* local_digits = digit_hists + w * RADIX_DIGITS * RADIX_BUCKETS;
+        USZ* local_pass = pass_hists + w * RADIX_BUCKETS;
+
+        radix_histograms(items + lo, hi - lo, local_digits);
+        sync.arrive_and_wait();
+
+        // every worker merges the same histograms, so they all agree on the passes
+        USZ merged[RADIX_DIGITS * RADIX_BUCKETS] = { 0 };
+        for (USZ o = 0; o < workers; o++) {
+            const USZ* other = digit_hists + o * RADIX_DIGITS * RADIX_BUCKETS;
+
+            for (USZ i = 0; i < RADIX_DIGITS * RADIX_BUCKETS; i++) {
+                merged[i] += other[i];
+            }
+        }
+
+        USZ passes[RADIX_DIGITS];
+        USZ num_passes = radix_passes(merged, count, passes);
+
+        KeyIndex* src = items;
+        KeyIndex* dst = scratch;
+
+        for (USZ p = 0; p < num_passes; p++) {
+            USZ digit = passes[p];
+
+            // histogram phase over this worker's slice of the current source
+            Mem::set(local_pass, 0, RADIX_BUCKETS * sizeof(USZ));
+            for (USZ i = lo; i < hi; i++) {
+                local_pass[radix_digit(src[i].key, digit)]++;
+            }
+
+            sync.arrive_and_wait();
+
+            // bucket b of worker w lands after all smaller buckets and after bucket b of earlier workers
+            USZ offsets[RADIX_BUCKETS];
+            USZ offset = 0;
+            for (USZ b = 0; b < RADIX_BUCKETS; b++) {
+                for (USZ o = 0; o < workers; o++) {
+                    if (o == w) {
+                        offsets[b] = offset;
+                    }
+
+                    offset += pass_hists[o * RADIX_BUCKETS + b];
+                }
+            }
+
+            // scatter phase, stable because slices and buckets keep their order
+            for (USZ i = lo; i < hi; i++) {
+                dst[offsets[radix_digit(src[i].key, digit)]++] = src[i];
+            }
+
+            sync.arrive_and_wait();
+
+            KeyIndex* tmp = src;
+            src = dst;
+            dst = tmp;
+        }
+
+        if (w == 0) {
+            result_in_scratch = (src != items);
+        }
+    };
+
+    std::thread* threads = Mem::alloc<std::thread>((workers - 1) * sizeof(std::thread));
+    for (USZ w = 1; w < workers; w++) {
+        new (&threads[w - 1]) std::thread(work, w);
+    }
+
+    work(0);
+
+    for (USZ w = 1; w < workers; w++) {
+        threads[w - 1].join();
+        threads[w - 1].~thread();
+    }
+
+    if (result_in_scratch) {
+        Mem::copy(items, scratch, count * sizeof(KeyIndex));
+    }
+
+    Mem::dealloc(threads);
+    Mem::dealloc(digit_hists);
+    Mem::dealloc(pass_hists);
+    Mem::dealloc(owned);
+}
+
+void Sort::radix(Block<KeyIndex, FixedArray> array, USZ workers) {
+    radix_parallel(Data::raw(array), Data::size(array), workers);
+}
+
+void Sort::radix(Block<KeyIndex, ExpandingArray> array, USZ workers) {
+    radix_parallel(Data::raw(array), Data::size(array), workers);
+}
+
+/*
+    string table
+*/
+
+StringTable* StringTable::create(USZ reserved, Hash::Group hash_type) {
+    StringTable* table = Mem::type_alloc<StringTable>();
+    new (&table->lock) std::mutex();
+    new (&table->count) std::atomic<U32>(1);
+
+    table->hash_type = hash_type;
+    table->arena = nullptr;
+    table->slots = nullptr;
+    table->slot_mask = 0;
+    Mem::set(table->pages, 0, sizeof(table->pages));
+
+    // keep the index under half full
+    rehash(table, next_pow2(max(reserved * 2, 16)));
+    return table;
+}
+
+void StringTable::destroy(StringTable* table) {
+    if (!table) {
+        return;
+    }
+
+    Chunk* chunk = table->arena;
+    while (chunk) {
+        Chunk* next = chunk->next;
+        Mem::dealloc(chunk);
+        chunk = next;
+    }
+
+    for (USZ p = 0; p < STRING_TABLE_MAX_PAGES && table->pages[p]; p++) {
+        Mem::dealloc(table->pages[p]);
+    }
+
+    Mem::dealloc(table->slots);
+    table->lock.~mutex();
+    table->count.~atomic();
+    Mem::dealloc(table);
+}
+
+StringTable::Entry* StringTable::entry(StringTable* table, U32 id) {
+    // pairs with the release in intern, an id below count has its entry and page visible
+    if (id == 0 || id >= table->count.load(std::memory_order_acquire)) {
+        THROW("invalid string id %u", id);
+    }
+
+    return &table->pages[id / STRING_TABLE_PAGE_ENTRIES][id % STRING_TABLE_PAGE_ENTRIES];
+}
+
+// copies a string into the arena, strings never move once stored
+const char* StringTable::store(StringTable* table, const char* str, USZ len) {
+    Chunk* chunk = table->arena;
+
+    if (!chunk || chunk->size - chunk->used < len + 1) {
+        USZ size = max(STRING_TABLE_ARENA_CHUNK, len + 1);
+        Chunk* fresh = Mem::type_alloc<Chunk>(size);
+        fresh->used = 0;
+        fresh->size = size;
+
+        // oversized strings get their own chunk behind the current one
+        if (chunk && size > STRING_TABLE_ARENA_CHUNK) {
+            fresh->next = chunk->next;
+            chunk->next = fresh;
+        } else {
+            fresh->next = chunk;
+            table->arena = fresh;
+        }
+
+        chunk = fresh;
+    }
+
+    char* dst = (char*) chunk->data + chunk->used;
+    Mem::copy(dst, str, len);
+    dst[len] = '\0';
+    chunk->used += len + 1;
+
+    return dst;
+}
+
+void StringTable::rehash(StringTable* table, USZ slots) {
+    U32* fresh = Mem::alloc<U32>(slots, sizeof(U32));
+    USZ mask = slots - 1;
+
+    // only called with the lock held, nothing else writes count
+    U32 count = table->count.load(std::memory_order_relaxed);
+
+    for (U32 id = 1; id < count; id++) {
+        USZ slot = entry(table, id)->hash & mask;
+
+        while (fresh[slot]) {
+            slot = (slot + 1) & mask;
+        }
+
+        fresh[slot] = id;
+    }
+
+    Mem::dealloc(table->slots);
+    table->slots = fresh;
+    table->slot_mask = mask;
+}
+
+// probes for a string while the lock is held, returns its slot
+static USZ string_table_probe(StringTable* table, const char* str, USZ len, U32 hash) {
+    USZ slot = hash & table->slot_mask;
+
+    while (U32 id = table->slots[slot]) {
+        StringTable::Entry* e = &table->pages[id / StringTable::STRING_TABLE_PAGE_ENTRIES][id % StringTable::STRING_TABLE_PAGE_ENTRIES];
+
+        if (e->hash == hash && e->length == len && Mem::compare(e->str, str, len) == 0) {
+            return slot;
+        }
+
+        slot = (slot + 1) & table->slot_mask;
+    }
+
+    return slot;
+}
+
+U32 StringTable::intern(StringTable* table, const char* str, USZ len) {
+    U32 hash = Hash::generate((const U8*) str, len, table->hash_type);
+    std::lock_guard<std::mutex> guard(table->lock);
+
+    USZ slot = string_table_probe(table, str, len, hash);
+    if (table->slots[slot]) {
+        return table->slots[slot];
+    }
+
+    U32 id = table->count.load(std::memory_order_relaxed);
+    USZ page = id / STRING_TABLE_PAGE_ENTRIES;
+
+    if (page >= STRING_TABLE_MAX_PAGES) {
+        THROW("string table full");
+    }
+
+    if (!table->pages[page]) {
+        table->pages[page] = Mem::alloc<Entry>(STRING_TABLE_PAGE_ENTRIES * sizeof(Entry));
+    }
+
+    Entry* e = &table->pages[page][id % STRING_TABLE_PAGE_ENTRIES];
+    e->str = store(table, str, len);
+    e->length = (U32) len;
+    e->hash = hash;
+
+    // publish the entry before the id can be observed by other threads
+    table->count.store(id + 1, std::memory_order_release);
+    table->slots[slot] = id;
+
+    if ((USZ) (id + 1) * 2 > table->slot_mask + 1) {
+        rehash(table, (table->slot_mask + 1) * 2);
+    }
+
+    return id;
+}
+
+U32 StringTable::intern(StringTable* table, const char* str) {
+    return intern(table, str, strlen(str));
+}
+
+U32 StringTable::find(StringTable* table, const char* str, USZ len) {
+    U32 hash = Hash::generate((const U8*) str, len, table->hash_type);
+    std::lock_guard<std::mutex> guard(table->lock);
+
+    return table->slots[string_table_probe(table, str, len, hash)];
+}
+
+const char* StringTable::str(StringTable* table, U32 id) {
+    return entry(table, id)->str;
+}
+
+U32 StringTable::length(StringTable* table, U32 id) {
+    return entry(table, id)->length;
+}
+
+U32 StringTable::hash(StringTable* table, U32 id) {
+    return entry(table, id)->hash;
+}
+
+USZ StringTable::size(StringTable* table) {
+    return table->count.load(std::memory_order_acquire) - 1;
+}
+
+StringTable* StringTable::global() {
+    static StringTable* table = create(1024);
+    return table;
+}
+
+U32 StringTable::intern(const char* str) {
+    return intern(global(), str);
+}
+
+const char* StringTable::str(U32 id) {
+    return str(global(), id);
+}
+
+}
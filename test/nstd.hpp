@@ -4,6 +4,12 @@
 #include <iostream>
 #include <cstring>
 #include <stdint.h>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <atomic>
+#include <new>
+#include <mutex>
 
 #ifdef STD_HEAP_TRACK
 #   include <map>
@@ -29,6 +35,13 @@ typedef double F64;
 
 inline USZ min(USZ a, USZ b) { return (a < b) ? a : b; };
 inline USZ max(USZ a, USZ b) { return (a < b) ? b : a; };
+inline USZ align_up(USZ v, USZ alignment) { return (v + alignment - 1) & ~(alignment - 1); };
+inline USZ next_pow2(USZ v) { USZ p = 1; while (p < v) p <<= 1; return p; };
+
+#ifndef CACHE_LINE_SIZE
+    // destructive interference size used to pad shared atomics
+    static constexpr USZ CACHE_LINE_SIZE = 64;
+#endif
 
 /*
     memory
@@ -140,35 +153,6 @@ struct Pair {
     static USZ compare_r(const Pair* a, const Pair* b);
 };
 
-struct ReferenceTable {
-    struct Item {
-        Pair region;
-        Item* next;
-    };
-
-    Hash::Group hash_type;
-    DynamicBlock<Item> allocator; 
-    List<Item*> references;
-
-    // creates a new reference table, this makes some allocations
-    static ReferenceTable* create(USZ width, Hash::Group hash_type = Hash::djb2);
-
-    // frees up all rescources in the reference table
-    static void destroy(ReferenceTable* table);
-
-    // gets an item by an arbitrary ptr
-    static Item* get_item(ReferenceTable* table, const U8* ptr);
-
-    // inserts a pair of items
-    static void insert(ReferenceTable* table, Pair data);
-
-    // finds an item by an arbitrary ptr
-    static U8* find(ReferenceTable* table, const U8* lptr);
-
-    // iterates over all key value pairs and calls it for each one
-    static void iterate(ReferenceTable* table, void (*it)(U8*, U8*));
-};
-
 struct FixedArray {
     const USZ element_size; // size of each element in the array
     const USZ elements;     // number of elements in the array
@@ -280,6 +264,186 @@ struct ExpandingArray {
     static bool equals(ExpandingArray* a, ExpandingArray* b);
 };
 
+/*
+    structure of arrays
+*/
+
+// non owning view over a contiguous typed range
+template <typename T>
+struct Span {
+    T* data;
+    USZ len;
+
+    T* begin() const { return data; }
+    T* end() const { return data + len; }
+    T& operator[](USZ idx) const { return data[idx]; }
+};
+
+// typed structure of arrays, every field gets its own contiguous aligned array
+template <typename... Fields>
+struct SoaArray {
+    static_assert(sizeof...(Fields) > 0, "soa array needs at least one field");
+    static_assert((std::is_trivially_copyable_v<Fields> && ...), "soa fields must be trivially copyable");
+
+    static constexpr USZ field_count = sizeof...(Fields);
+
+#   ifndef SOA_FIELD_ALIGNMENT
+        // alignment of each field array (cache line, also covers avx512 loads)
+        static constexpr USZ SOA_FIELD_ALIGNMENT = 64;
+#   endif
+
+    template <USZ F>
+    using Field = std::tuple_element_t<F, std::tuple<Fields...>>;
+
+    using Row = std::tuple<Fields&...>;
+
+    USZ max_elements;          // rows that fit in the current allocation
+    USZ elements_used;         // rows in use
+    U8* data;                  // single allocation backing every field
+    U8* fields[field_count];   // aligned start of each field array within data
+
+    // creates a soa array with space for reserved rows
+    static SoaArray* create(USZ reserved);
+
+    // destroys a soa array
+    static void destroy(SoaArray* array);
+
+    // grows every field to hold at least elements rows in one allocation
+    static void reserve(SoaArray* array, USZ elements);
+
+    // sets the row count, new rows are zeroed
+    static void resize(SoaArray* array, USZ elements);
+
+    // pushes a row to the back of the array and returns its index
+    static USZ push_back(SoaArray* array, const Fields&... row);
+
+    // pops a row off of the back of the array
+    static void pop_back(SoaArray* array);
+
+    // erases a row by moving the last row into its place
+    static void swap_erase(SoaArray* array, USZ idx);
+
+    // returns a typed pointer to the start of a field array
+    template <USZ F>
+    static Field<F>* field(SoaArray* array);
+
+    // returns a span over the used rows of a field
+    template <USZ F>
+    static Span<Field<F>> span(SoaArray* array);
+
+    // returns references to every field of a row
+    static Row row(SoaArray* array, USZ idx);
+
+    // calls it with references to every field of each row
+    template <typename It>
+    static void iterate(SoaArray* array, It it);
+
+    // returns total rows in the array
+    static USZ size(SoaArray* array);
+
+    // returns the total allocated rows in the array
+    static USZ capacity(SoaArray* array);
+
+    // clears the array without releasing memory
+    static void clear(SoaArray* array);
+
+private:
+    template <USZ... I>
+    static void write_row(SoaArray* array, USZ idx, std::index_sequence<I...>, const Fields&... row);
+
+    template <USZ... I>
+    static void move_row(SoaArray* array, USZ dst, USZ src, std::index_sequence<I...>);
+
+    template <USZ... I>
+    static Row make_row(SoaArray* array, USZ idx, std::index_sequence<I...>);
+};
+
+/*
+    concurrency
+*/
+
+// bounded lock free single producer single consumer ring
+template <typename T>
+struct SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "ring items must be trivially copyable");
+
+    // producer line
+    alignas(CACHE_LINE_SIZE) std::atomic<USZ> tail;
+    USZ cached_head;
+
+    // consumer line
+    alignas(CACHE_LINE_SIZE) std::atomic<USZ> head;
+    USZ cached_tail;
+
+    // shared read only line
+    alignas(CACHE_LINE_SIZE) USZ mask;
+    T* slots;
+
+    // creates a ring, capacity is rounded up to a power of two
+    static SpscRing* create(USZ capacity);
+
+    // destroys a ring
+    static void destroy(SpscRing* ring);
+
+    // pushes an item, returns false when full (producer only)
+    static bool push(SpscRing* ring, const T& item);
+
+    // pushes up to count items, returns the number pushed (producer only)
+    static USZ push_batch(SpscRing* ring, const T* items, USZ count);
+
+    // pops an item, returns false when empty (consumer only)
+    static bool pop(SpscRing* ring, T* item);
+
+    // pops up to count items, returns the number popped (consumer only)
+    static USZ pop_batch(SpscRing* ring, T* items, USZ count);
+
+    // returns an approximate number of queued items
+    static USZ size(SpscRing* ring);
+
+    // returns the number of slots in the ring
+    static USZ capacity(SpscRing* ring);
+};
+
+// bounded lock free multi producer multi consumer queue using per slot sequence numbers
+template <typename T>
+struct MpmcQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "queue items must be trivially copyable");
+
+    struct Cell {
+        std::atomic<USZ> sequence;
+        T data;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<USZ> enqueue_pos;
+    alignas(CACHE_LINE_SIZE) std::atomic<USZ> dequeue_pos;
+    alignas(CACHE_LINE_SIZE) USZ mask;
+    Cell* cells;
+
+    // creates a queue, capacity is rounded up to a power of two
+    static MpmcQueue* create(USZ capacity);
+
+    // destroys a queue
+    static void destroy(MpmcQueue* queue);
+
+    // pushes an item, returns false when full
+    static bool push(MpmcQueue* queue, const T& item);
+
+    // claims a run of up to count free slots and pushes into them, returns the number pushed
+    static USZ push_batch(MpmcQueue* queue, const T* items, USZ count);
+
+    // pops an item, returns false when empty
+    static bool pop(MpmcQueue* queue, T* item);
+
+    // claims a run of up to count ready slots and pops them, returns the number popped
+    static USZ pop_batch(MpmcQueue* queue, T* items, USZ count);
+
+    // returns an approximate number of queued items
+    static USZ size(MpmcQueue* queue);
+
+    // returns the number of slots in the queue
+    static USZ capacity(MpmcQueue* queue);
+};
+
 /*
     generic interface
 */
@@ -315,6 +479,154 @@ template <typename T> using List = Block<T, FixedArray>;
 template <typename T> using Vector = Block<T, ExpandingArray>;
 using String = Block<U8, ExpandingArray>;
 
+struct ReferenceTable {
+    struct Item {
+        Pair region;
+        Item* next;
+    };
+
+    Hash::Group hash_type;
+    DynamicBlock<Item> allocator; 
+    List<Item*> references;
+
+    // creates a new reference table, this makes some allocations
+    static ReferenceTable* create(USZ width, Hash::Group hash_type = Hash::djb2);
+
+    // frees up all rescources in the reference table
+    static void destroy(ReferenceTable* table);
+
+    // gets an item by an arbitrary ptr
+    static Item* get_item(ReferenceTable* table, const U8* ptr);
+
+    // inserts a pair of items
+    static void insert(ReferenceTable* table, Pair data);
+
+    // finds an item by an arbitrary ptr
+    static U8* find(ReferenceTable* table, const U8* lptr);
+
+    // iterates over all key value pairs and calls it for each one
+    static void iterate(ReferenceTable* table, void (*it)(U8*, U8*));
+};
+
+/*
+    sorting
+*/
+
+struct Sort {
+
+#   ifndef RADIX_SORT_MIN
+        // below this many items an insertion sort beats the histogram passes
+        static constexpr USZ RADIX_SORT_MIN = 64;
+#   endif
+
+#   ifndef RADIX_SORT_PARALLEL_MIN
+        // below this many items the parallel sort runs on the calling thread
+        static constexpr USZ RADIX_SORT_PARALLEL_MIN = 1 << 16;
+#   endif
+
+    // 64 bit sort key with the index of the item it belongs to
+    struct KeyIndex {
+        U64 key;
+        U32 index;
+    };
+
+    // stable lsd radix sort by key, scratch must hold count items (allocated when null)
+    static void radix(KeyIndex* items, USZ count, KeyIndex* scratch = nullptr);
+
+    // radix sort with histogram and scatter passes split across workers (0 = hardware threads)
+    static void radix_parallel(KeyIndex* items, USZ count, USZ workers = 0, KeyIndex* scratch = nullptr);
+
+    // sorts a fixed array of key index pairs
+    static void radix(Block<KeyIndex, FixedArray> array, USZ workers = 1);
+
+    // sorts an expanding array of key index pairs
+    static void radix(Block<KeyIndex, ExpandingArray> array, USZ workers = 1);
+
+    // stable insertion sort used for small inputs
+    static void insertion(KeyIndex* items, USZ count);
+};
+
+/*
+    strings
+*/
+
+// interned strings, each distinct string maps to a stable 32 bit id (0 is never a valid id)
+struct StringTable {
+
+#   ifndef STRING_TABLE_PAGE_ENTRIES
+        // entries per page, pages never move so lookups by id need no lock
+        static constexpr USZ STRING_TABLE_PAGE_ENTRIES = 1024;
+        static constexpr USZ STRING_TABLE_MAX_PAGES = 4096;
+#   endif
+
+#   ifndef STRING_TABLE_ARENA_CHUNK
+        // bytes per arena chunk holding the string data
+        static constexpr USZ STRING_TABLE_ARENA_CHUNK = 64 * 1024;
+#   endif
+
+    struct Entry {
+        const char* str;   // null terminated bytes in the arena
+        U32 length;
+        U32 hash;
+    };
+
+    struct Chunk {
+        Chunk* next;
+        USZ used;
+        USZ size;
+        U8 data[];
+    };
+
+    Hash::Group hash_type;
+    std::mutex lock;           // guards inserts and the slot index
+    Chunk* arena;
+    U32* slots;                // open addressed index of ids, 0 is empty
+    USZ slot_mask;
+    std::atomic<U32> count;    // ids handed out, including the reserved 0, published after the entry
+    Entry* pages[STRING_TABLE_MAX_PAGES];
+
+    // creates a string table with room for reserved strings before rehashing
+    static StringTable* create(USZ reserved, Hash::Group hash_type = Hash::fnv1a);
+
+    // frees the table and every interned string
+    static void destroy(StringTable* table);
+
+    // returns the id of a string, inserting it when new
+    static U32 intern(StringTable* table, const char* str, USZ len);
+
+    // returns the id of a null terminated string, inserting it when new
+    static U32 intern(StringTable* table, const char* str);
+
+    // returns the id of a string or 0 if it was never interned
+    static U32 find(StringTable* table, const char* str, USZ len);
+
+    // returns the interned bytes of an id
+    static const char* str(StringTable* table, U32 id);
+
+    // returns the length of an id's string
+    static U32 length(StringTable* table, U32 id);
+
+    // returns the precomputed hash of an id's string
+    static U32 hash(StringTable* table, U32 id);
+
+    // returns the number of interned strings
+    static USZ size(StringTable* table);
+
+    // process wide table used for shader, uniform and asset names
+    static StringTable* global();
+
+    // interns into the global table
+    static U32 intern(const char* str);
+
+    // returns bytes of an id in the global table
+    static const char* str(U32 id);
+
+private:
+    static Entry* entry(StringTable* table, U32 id);
+    static const char* store(StringTable* table, const char* str, USZ len);
+    static void rehash(StringTable* table, USZ slots);
+};
+
 // wrapper of malloc for profiling
 struct Mem {
 
@@ -388,6 +700,12 @@ struct Mem {
     template <typename T>
     inline static T* type_alloc(USZ padding = 0);
 
+    template <typename T>
+    inline static T* aligned_alloc(USZ size, USZ alignment);
+
+    template <typename T>
+    inline static void aligned_dealloc(T* ptr);
+
     template <typename B, typename A>
     inline static void copy(B* dst, A* ptr, USZ size);
 
@@ -656,7 +974,7 @@ inline T* Mem::alloc(USZ count, USZ size) {
 
 #   endif
 
-    return (T*) calloc(count, size); 
+    return ret;
 }
 
 template <typename T>
@@ -701,6 +1019,26 @@ inline T* Mem::type_alloc(USZ padding) {
     return alloc<T>(sizeof(T) + padding);
 }
 
+template <typename T>
+inline T* Mem::aligned_alloc(USZ size, USZ alignment) {
+    // the original allocation is stashed right before the aligned address
+    U8* raw = alloc<U8>(size + alignment + sizeof(U8*));
+    if (!raw) {
+        return nullptr;
+    }
+
+    U8* aligned = (U8*) align_up((USZ) (raw + sizeof(U8*)), alignment);
+    ((U8**) aligned)[-1] = raw;
+    return (T*) aligned;
+}
+
+template <typename T>
+inline void Mem::aligned_dealloc(T* ptr) {
+    if (ptr) {
+        dealloc(((U8**) ptr)[-1]);
+    }
+}
+
 template <typename B, typename A>
 inline void Mem::copy(B* dst, A* ptr, USZ size) {
     memcpy(dst, ptr, size);
@@ -972,6 +1310,497 @@ inline void Data::join(Block<U8, ExpandingArray> arr1, const U8* data, USZ len)
     ExpandingArray::join_raw(arr1.structure, data, len);
 }
 
+/*
+    structure of arrays
+*/
+
+template <typename... Fields>
+SoaArray<Fields...>* SoaArray<Fields...>::create(USZ reserved) {
+    SoaArray* array = Mem::type_alloc<SoaArray>();
+    array->max_elements = 0;
+    array->elements_used = 0;
+    array->data = nullptr;
+    Mem::set(array->fields, 0, sizeof(array->fields));
+
+    reserve(array, max(reserved, 1));
+    return array;
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::destroy(SoaArray* array) {
+    if (array) {
+        Mem::dealloc(array->data);
+        Mem::dealloc(array);
+    }
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::reserve(SoaArray* array, USZ elements) {
+    if (elements <= array->max_elements) {
+        return;
+    }
+
+    // lay fields out back to back, each one starting on its own alignment boundary
+    constexpr USZ field_sizes[field_count] = { sizeof(Fields)... };
+    USZ offsets[field_count];
+    USZ total = 0;
+
+    for (USZ f = 0; f < field_count; f++) {
+        offsets[f] = total;
+        total = align_up(total + field_sizes[f] * elements, SOA_FIELD_ALIGNMENT);
+    }
+
+    U8* data = Mem::alloc<U8>(total + SOA_FIELD_ALIGNMENT);
+    if (!data) {
+        THROW("soa array allocation failed");
+    }
+
+    U8* base = (U8*) align_up((USZ) data, SOA_FIELD_ALIGNMENT);
+
+    for (USZ f = 0; f < field_count; f++) {
+        U8* field_data = base + offsets[f];
+
+        if (array->elements_used) {
+            Mem::copy(field_data, array->fields[f], field_sizes[f] * array->elements_used);
+        }
+
+        array->fields[f] = field_data;
+    }
+
+    Mem::dealloc(array->data);
+    array->data = data;
+    array->max_elements = elements;
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::resize(SoaArray* array, USZ elements) {
+    constexpr USZ field_sizes[field_count] = { sizeof(Fields)... };
+
+    reserve(array, elements);
+
+    if (elements > array->elements_used) {
+        USZ added = elements - array->elements_used;
+
+        for (USZ f = 0; f < field_count; f++) {
+            Mem::set(array->fields[f] + field_sizes[f] * array->elements_used, 0, field_sizes[f] * added);
+        }
+    }
+
+    array->elements_used = elements;
+}
+
+template <typename... Fields>
+USZ SoaArray<Fields...>::push_back(SoaArray* array, const Fields&... row) {
+    if (array->elements_used == array->max_elements) {
+        // the row may reference this array's own storage, copy it before reserve frees that
+        std::tuple<Fields...> copy(row...);
+        reserve(array, array->max_elements * 2);
+
+        USZ idx = array->elements_used++;
+        std::apply([&](const Fields&... fields) {
+            write_row(array, idx, std::index_sequence_for<Fields...>{}, fields...);
+        }, copy);
+        return idx;
+    }
+
+    USZ idx = array->elements_used++;
+    write_row(array, idx, std::index_sequence_for<Fields...>{}, row...);
+    return idx;
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::pop_back(SoaArray* array) {
+    if (array->elements_used == 0) {
+        THROW("pop from empty soa array");
+    }
+
+    array->elements_used--;
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::swap_erase(SoaArray* array, USZ idx) {
+    if (idx >= array->elements_used) {
+        THROW("index out of bounds");
+    }
+
+    USZ last = array->elements_used - 1;
+    if (idx != last) {
+        move_row(array, idx, last, std::index_sequence_for<Fields...>{});
+    }
+
+    array->elements_used--;
+}
+
+template <typename... Fields>
+template <USZ F>
+typename SoaArray<Fields...>::template Field<F>* SoaArray<Fields...>::field(SoaArray* array) {
+    return (Field<F>*) array->fields[F];
+}
+
+template <typename... Fields>
+template <USZ F>
+Span<typename SoaArray<Fields...>::template Field<F>> SoaArray<Fields...>::span(SoaArray* array) {
+    return Span<Field<F>> { .data = field<F>(array), .len = array->elements_used };
+}
+
+template <typename... Fields>
+typename SoaArray<Fields...>::Row SoaArray<Fields...>::row(SoaArray* array, USZ idx) {
+    if (idx >= array->elements_used) {
+        THROW("index out of bounds");
+    }
+
+    return make_row(array, idx, std::index_sequence_for<Fields...>{});
+}
+
+template <typename... Fields>
+template <typename It>
+void SoaArray<Fields...>::iterate(SoaArray* array, It it) {
+    for (USZ i = 0; i < array->elements_used; i++) {
+        std::apply(it, make_row(array, i, std::index_sequence_for<Fields...>{}));
+    }
+}
+
+template <typename... Fields>
+USZ SoaArray<Fields...>::size(SoaArray* array) {
+    return array->elements_used;
+}
+
+template <typename... Fields>
+USZ SoaArray<Fields...>::capacity(SoaArray* array) {
+    return array->max_elements;
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::clear(SoaArray* array) {
+    array->elements_used = 0;
+}
+
+template <typename... Fields>
+template <USZ... I>
+void SoaArray<Fields...>::write_row(SoaArray* array, USZ idx, std::index_sequence<I...>, const Fields&... row) {
+    ((field<I>(array)[idx] = row), ...);
+}
+
+template <typename... Fields>
+template <USZ... I>
+void SoaArray<Fields...>::move_row(SoaArray* array, USZ dst, USZ src, std::index_sequence<I...>) {
+    ((field<I>(array)[dst] = field<I>(array)[src]), ...);
+}
+
+template <typename... Fields>
+template <USZ... I>
+typename SoaArray<Fields...>::Row SoaArray<Fields...>::make_row(SoaArray* array, USZ idx, std::index_sequence<I...>) {
+    return Row(field<I>(array)[idx]...);
+}
+
+/*
+    spsc ring
+*/
+
+template <typename T>
+SpscRing<T>* SpscRing<T>::create(USZ capacity) {
+    // the atomics need constructing, the allocation only hands back raw memory
+    SpscRing* ring = new (Mem::aligned_alloc<SpscRing>(sizeof(SpscRing), CACHE_LINE_SIZE)) SpscRing;
+    USZ slots = next_pow2(max(capacity, 2));
+
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->cached_head = 0;
+    ring->cached_tail = 0;
+    ring->mask = slots - 1;
+    ring->slots = Mem::aligned_alloc<T>(slots * sizeof(T), CACHE_LINE_SIZE);
+
+    return ring;
+}
+
+template <typename T>
+void SpscRing<T>::destroy(SpscRing* ring) {
+    if (ring) {
+        Mem::aligned_dealloc(ring->slots);
+        ring->~SpscRing();
+        Mem::aligned_dealloc(ring);
+    }
+}
+
+template <typename T>
+bool SpscRing<T>::push(SpscRing* ring, const T& item) {
+    USZ tail = ring->tail.load(std::memory_order_relaxed);
+
+    // only reload the consumer index when the cached one says we are full
+    if (tail - ring->cached_head > ring->mask) {
+        ring->cached_head = ring->head.load(std::memory_order_acquire);
+
+        if (tail - ring->cached_head > ring->mask) {
+            return false;
+        }
+    }
+
+    ring->slots[tail & ring->mask] = item;
+    ring->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+USZ SpscRing<T>::push_batch(SpscRing* ring, const T* items, USZ count) {
+    USZ tail = ring->tail.load(std::memory_order_relaxed);
+    USZ slots = ring->mask + 1;
+
+    if (slots - (tail - ring->cached_head) < count) {
+        ring->cached_head = ring->head.load(std::memory_order_acquire);
+    }
+
+    USZ n = min(count, slots - (tail - ring->cached_head));
+    if (n == 0) {
+        return 0;
+    }
+
+    // copy in at most two runs, wrapping at the end of the slots
+    USZ start = tail & ring->mask;
+    USZ first = min(n, slots - start);
+    Mem::copy(ring->slots + start, items, first * sizeof(T));
+    Mem::copy(ring->slots, items + first, (n - first) * sizeof(T));
+
+    ring->tail.store(tail + n, std::memory_order_release);
+    return n;
+}
+
+template <typename T>
+bool SpscRing<T>::pop(SpscRing* ring, T* item) {
+    USZ head = ring->head.load(std::memory_order_relaxed);
+
+    // only reload the producer index when the cached one says we are empty
+    if (head == ring->cached_tail) {
+        ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+
+        if (head == ring->cached_tail) {
+            return false;
+        }
+    }
+
+    *item = ring->slots[head & ring->mask];
+    ring->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+USZ SpscRing<T>::pop_batch(SpscRing* ring, T* items, USZ count) {
+    USZ head = ring->head.load(std::memory_order_relaxed);
+
+    if (ring->cached_tail - head < count) {
+        ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+    }
+
+    USZ n = min(count, ring->cached_tail - head);
+    if (n == 0) {
+        return 0;
+    }
+
+    USZ slots = ring->mask + 1;
+    USZ start = head & ring->mask;
+    USZ first = min(n, slots - start);
+    Mem::copy(items, ring->slots + start, first * sizeof(T));
+    Mem::copy(items + first, ring->slots, (n - first) * sizeof(T));
+
+    ring->head.store(head + n, std::memory_order_release);
+    return n;
+}
+
+template <typename T>
+USZ SpscRing<T>::size(SpscRing* ring) {
+    return ring->tail.load(std::memory_order_acquire) - ring->head.load(std::memory_order_acquire);
+}
+
+template <typename T>
+USZ SpscRing<T>::capacity(SpscRing* ring) {
+    return ring->mask + 1;
+}
+
+/*
+    mpmc queue
+*/
+
+template <typename T>
+MpmcQueue<T>* MpmcQueue<T>::create(USZ capacity) {
+    MpmcQueue* queue = new (Mem::aligned_alloc<MpmcQueue>(sizeof(MpmcQueue), CACHE_LINE_SIZE)) MpmcQueue;
+    USZ slots = next_pow2(max(capacity, 2));
+
+    queue->enqueue_pos.store(0, std::memory_order_relaxed);
+    queue->dequeue_pos.store(0, std::memory_order_relaxed);
+    queue->mask = slots - 1;
+    queue->cells = Mem::aligned_alloc<Cell>(slots * sizeof(Cell), CACHE_LINE_SIZE);
+
+    // a cell is free for the producer at position p when its sequence equals p
+    for (USZ i = 0; i < slots; i++) {
+        new (&queue->cells[i]) Cell;
+        queue->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    return queue;
+}
+
+template <typename T>
+void MpmcQueue<T>::destroy(MpmcQueue* queue) {
+    if (queue) {
+        for (USZ i = 0; i <= queue->mask; i++) {
+            queue->cells[i].~Cell();
+        }
+
+        Mem::aligned_dealloc(queue->cells);
+        queue->~MpmcQueue();
+        Mem::aligned_dealloc(queue);
+    }
+}
+
+template <typename T>
+bool MpmcQueue<T>::push(MpmcQueue* queue, const T& item) {
+    USZ pos = queue->enqueue_pos.load(std::memory_order_relaxed);
+    Cell* cell;
+
+    for (;;) {
+        cell = &queue->cells[pos & queue->mask];
+        USZ seq = cell->sequence.load(std::memory_order_acquire);
+        S64 diff = (S64) seq - (S64) pos;
+
+        if (diff == 0) {
+            if (queue->enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = queue->enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->data = item;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+USZ MpmcQueue<T>::push_batch(MpmcQueue* queue, const T* items, USZ count) {
+    USZ pos = queue->enqueue_pos.load(std::memory_order_relaxed);
+    USZ n;
+
+    for (;;) {
+        // count the run of free cells starting at pos, claimed cells stay free until we publish
+        n = 0;
+        while (n < count && n <= queue->mask) {
+            USZ seq = queue->cells[(pos + n) & queue->mask].sequence.load(std::memory_order_acquire);
+
+            if (seq != pos + n) {
+                break;
+            }
+
+            n++;
+        }
+
+        if (n == 0) {
+            USZ seq = queue->cells[pos & queue->mask].sequence.load(std::memory_order_acquire);
+
+            if ((S64) seq - (S64) pos < 0) {
+                return 0;
+            }
+
+            pos = queue->enqueue_pos.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        if (queue->enqueue_pos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    for (USZ i = 0; i < n; i++) {
+        Cell* cell = &queue->cells[(pos + i) & queue->mask];
+        cell->data = items[i];
+        cell->sequence.store(pos + i + 1, std::memory_order_release);
+    }
+
+    return n;
+}
+
+template <typename T>
+bool MpmcQueue<T>::pop(MpmcQueue* queue, T* item) {
+    USZ pos = queue->dequeue_pos.load(std::memory_order_relaxed);
+    Cell* cell;
+
+    for (;;) {
+        cell = &queue->cells[pos & queue->mask];
+        USZ seq = cell->sequence.load(std::memory_order_acquire);
+        S64 diff = (S64) seq - (S64) (pos + 1);
+
+        if (diff == 0) {
+            if (queue->dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = queue->dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    *item = cell->data;
+    cell->sequence.store(pos + queue->mask + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+USZ MpmcQueue<T>::pop_batch(MpmcQueue* queue, T* items, USZ count) {
+    USZ pos = queue->dequeue_pos.load(std::memory_order_relaxed);
+    USZ n;
+
+    for (;;) {
+        // count the run of published cells starting at pos
+        n = 0;
+        while (n < count && n <= queue->mask) {
+            USZ seq = queue->cells[(pos + n) & queue->mask].sequence.load(std::memory_order_acquire);
+
+            if (seq != pos + n + 1) {
+                break;
+            }
+
+            n++;
+        }
+
+        if (n == 0) {
+            USZ seq = queue->cells[pos & queue->mask].sequence.load(std::memory_order_acquire);
+
+            if ((S64) seq - (S64) (pos + 1) < 0) {
+                return 0;
+            }
+
+            pos = queue->dequeue_pos.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        if (queue->dequeue_pos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    for (USZ i = 0; i < n; i++) {
+        Cell* cell = &queue->cells[(pos + i) & queue->mask];
+        items[i] = cell->data;
+        cell->sequence.store(pos + i + queue->mask + 1, std::memory_order_release);
+    }
+
+    return n;
+}
+
+template <typename T>
+USZ MpmcQueue<T>::size(MpmcQueue* queue) {
+    USZ enq = queue->enqueue_pos.load(std::memory_order_acquire);
+    USZ deq = queue->dequeue_pos.load(std::memory_order_acquire);
+    return (enq > deq) ? enq - deq : 0;
+}
+
+template <typename T>
+USZ MpmcQueue<T>::capacity(MpmcQueue* queue) {
+    return queue->mask + 1;
+}
+
 }
 
 #endif
\ No newline at end of file
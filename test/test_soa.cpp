@@ -0,0 +1,131 @@
+// g++ -std=c++20 -O1 test_soa.cpp nstd.cpp -o test_soa -lpthread
+#include "nstd.hpp"
+
+using namespace nstd;
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { LOGE("check failed: %s (line %i)", #cond, __LINE__); failures++; } } while (0)
+
+typedef SoaArray<F32, U32, U8> Particles;
+
+static bool aligned(const void* ptr) {
+    return (USZ) ptr % Particles::SOA_FIELD_ALIGNMENT == 0;
+}
+
+static void test_reserve() {
+    Particles* particles = Particles::create(4);
+    CHECK(Particles::capacity(particles) == 4);
+    CHECK(Particles::size(particles) == 0);
+
+    for (U32 i = 0; i < 3; i++) {
+        Particles::push_back(particles, (F32) i, i * 2, (U8) i);
+    }
+
+    // growing keeps every row and the alignment of every field
+    Particles::reserve(particles, 100);
+    CHECK(Particles::capacity(particles) == 100);
+    CHECK(Particles::size(particles) == 3);
+    CHECK(aligned(Particles::field<0>(particles)));
+    CHECK(aligned(Particles::field<1>(particles)));
+    CHECK(aligned(Particles::field<2>(particles)));
+
+    for (U32 i = 0; i < 3; i++) {
+        auto [x, id, flag] = Particles::row(particles, i);
+        CHECK(x == (F32) i && id == i * 2 && flag == (U8) i);
+    }
+
+    // shrinking requests are ignored
+    Particles::reserve(particles, 2);
+    CHECK(Particles::capacity(particles) == 100);
+
+    Particles::destroy(particles);
+}
+
+static void test_resize() {
+    Particles* particles = Particles::create(1);
+    Particles::push_back(particles, 1.0f, 7u, (U8) 1);
+
+    // new rows are zeroed, old rows kept
+    Particles::resize(particles, 50);
+    CHECK(Particles::size(particles) == 50);
+    CHECK(Particles::field<1>(particles)[0] == 7);
+
+    bool zeroed = true;
+    for (U32 i = 1; i < 50; i++) {
+        auto [x, id, flag] = Particles::row(particles, i);
+        zeroed = zeroed && x == 0.0f && id == 0 && flag == 0;
+    }
+    CHECK(zeroed);
+
+    Particles::resize(particles, 1);
+    CHECK(Particles::size(particles) == 1);
+
+    Particles::swap_erase(particles, 0);
+    CHECK(Particles::size(particles) == 0);
+
+    Particles::destroy(particles);
+}
+
+static void test_iterate() {
+    Particles* particles = Particles::create(2);
+    for (U32 i = 0; i < 1000; i++) {
+        Particles::push_back(particles, (F32) i, i, (U8) (i & 0xFF));
+    }
+
+    // rows are written through the references iterate hands out
+    Particles::iterate(particles, [](F32& x, U32& id, U8&) {
+        x += (F32) id;
+    });
+
+    Span<F32> xs = Particles::span<0>(particles);
+    CHECK(xs.len == 1000);
+
+    bool doubled = true;
+    U32 i = 0;
+    for (F32 x : xs) {
+        doubled = doubled && x == (F32) (i++ * 2);
+    }
+    CHECK(doubled);
+
+    Particles::swap_erase(particles, 0);
+    CHECK(Particles::size(particles) == 999);
+    CHECK(Particles::field<1>(particles)[0] == 999);
+
+    Particles::destroy(particles);
+}
+
+static void test_push_own_row() {
+    Particles* particles = Particles::create(1);
+    Particles::push_back(particles, 3.0f, 9u, (U8) 5);
+
+    // the pushed row references the array's storage while the push reallocates it
+    for (int i = 0; i < 8; i++) {
+        auto [x, id, flag] = Particles::row(particles, 0);
+        Particles::push_back(particles, x, id, flag);
+    }
+
+    bool copied = true;
+    for (U32 i = 0; i < Particles::size(particles); i++) {
+        auto [x, id, flag] = Particles::row(particles, i);
+        copied = copied && x == 3.0f && id == 9 && flag == 5;
+    }
+    CHECK(copied);
+
+    Particles::destroy(particles);
+}
+
+int main() {
+    test_reserve();
+    test_resize();
+    test_iterate();
+    test_push_own_row();
+
+    if (failures) {
+        LOGE("soa array: %i checks failed", failures);
+        return 1;
+    }
+
+    LOGI("soa array: all checks passed");
+    return 0;
+}